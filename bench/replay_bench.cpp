@@ -0,0 +1,170 @@
+#include <thread_pool/thread_pool.hpp>
+#include <thread_pool/queue/lock_free_linked_queue.hpp>
+#include <thread_pool/queue/naive_blocking_queue.hpp>
+#include <thread_pool/queue/ring_blocking_queue.hpp>
+#include <thread_pool/queue/segmented_ring_blocking_queue.hpp>
+#include <thread_pool/trace/workload_recorder.hpp>
+#include <thread_pool/trace/workload_replay.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+// Replays a recorded workload against every queue type and reports throughput and latency percentiles.
+// usage: thread_pool_replay_bench [--threads N] [--record FILE] [TRACE]
+// Without TRACE a synthetic mix (mostly short tasks, some long ones, two submitters) is recorded first;
+// --record saves the trace that is replayed, so it can be edited or reused.
+
+namespace
+{
+	using namespace thread_pool;
+
+	struct RecordingPolicy: DefaultPolicy
+	{
+		using metrics = WorkloadRecorder;
+	};
+
+	void burn(std::chrono::nanoseconds duration)
+	{
+		const auto until = std::chrono::steady_clock::now() + duration;
+		while(std::chrono::steady_clock::now() < until)
+		{
+		}
+	}
+
+	WorkloadTrace record_synthetic(std::size_t threads)
+	{
+		ThreadPool<NaiveBlockingQueue, RecordingPolicy> pool(threads);
+
+		auto submitter = [&pool](unsigned seed)
+		{
+			std::mt19937 random(seed);
+			std::bernoulli_distribution long_task(0.05);
+			std::uniform_int_distribution<int> short_us(5, 50);
+			std::uniform_int_distribution<int> gap_us(20, 200);
+
+			std::vector<std::future<void>> tasks;
+			for(int i = 0; i < 2000; ++i)
+			{
+				if(long_task(random))
+				{
+					tasks.push_back(pool.enqueue(TaskLabel("long"), burn, std::chrono::milliseconds(1)));
+				}
+				else
+				{
+					tasks.push_back(pool.enqueue(TaskLabel("short"), burn, std::chrono::microseconds(short_us(random))));
+				}
+				std::this_thread::sleep_for(std::chrono::microseconds(gap_us(random)));
+			}
+			for(auto& task: tasks)
+			{
+				task.get();
+			}
+		};
+
+		std::thread submitter_1(submitter, 1u);
+		std::thread submitter_2(submitter, 2u);
+		submitter_1.join();
+		submitter_2.join();
+
+		return pool.metrics().trace();
+	}
+
+	void print_latency(const char* name, const LatencySummary& summary)
+	{
+		const auto us = [](std::chrono::nanoseconds value){ return std::chrono::duration<double, std::micro>(value).count(); };
+		std::cout << "  " << std::setw(11) << name
+				<< "  p50 " << std::setw(9) << us(summary.p50)
+				<< "  p90 " << std::setw(9) << us(summary.p90)
+				<< "  p99 " << std::setw(9) << us(summary.p99)
+				<< "  max " << std::setw(9) << us(summary.max) << " us\n";
+	}
+
+	template<template<typename> class Q, typename... QueueArgs>
+	void run(const char* name, const WorkloadTrace& trace, std::size_t threads, QueueArgs... queue_args)
+	{
+		ThreadPool<Q> pool(threads, 1, queue_args...);
+		const ReplayResult result = replay_workload(pool, trace);
+
+		std::cout << std::fixed << std::setprecision(1)
+				<< name << ": " << result.tasks << " tasks, " << result.tasks_per_second << " tasks/s, makespan "
+				<< std::chrono::duration<double, std::milli>(result.makespan).count() << " ms\n";
+		print_latency("queue wait", result.queue_wait);
+		print_latency("end to end", result.end_to_end);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::size_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+	std::string record_path;
+	std::string trace_path;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		const std::string arg = argv[i];
+		if(arg == "--threads" && i + 1 < argc)
+		{
+			threads = std::strtoul(argv[++i], nullptr, 10);
+		}
+		else if(arg == "--record" && i + 1 < argc)
+		{
+			record_path = argv[++i];
+		}
+		else if(!arg.empty() && arg[0] != '-')
+		{
+			trace_path = arg;
+		}
+		else
+		{
+			std::cerr << "usage: " << argv[0] << " [--threads N] [--record FILE] [TRACE]\n";
+			return 1;
+		}
+	}
+	if(threads == 0)
+	{
+		std::cerr << "--threads has to be positive\n";
+		return 1;
+	}
+
+	WorkloadTrace trace;
+	if(!trace_path.empty())
+	{
+		std::ifstream in(trace_path);
+		if(!in)
+		{
+			std::cerr << "cannot open " << trace_path << "\n";
+			return 1;
+		}
+		trace = WorkloadTrace::read(in);
+	}
+	else
+	{
+		trace = record_synthetic(threads);
+	}
+
+	if(!record_path.empty())
+	{
+		std::ofstream out(record_path);
+		trace.write(out);
+	}
+
+	const std::size_t capacity = std::max<std::size_t>(trace.events.size(), 1);
+	std::cout << trace.events.size() << " recorded tasks, " << threads << " threads\n";
+	run<NaiveBlockingQueue>("NaiveBlockingQueue", trace, threads);
+	run<EventCountNaiveBlockingQueue>("EventCountNaiveBlockingQueue", trace, threads);
+	run<RingBlockingQueue>("RingBlockingQueue", trace, threads, capacity);
+	run<EventCountRingBlockingQueue>("EventCountRingBlockingQueue", trace, threads, capacity);
+	run<SegmentedRingBlockingQueue>("SegmentedRingBlockingQueue", trace, threads, capacity);
+	run<LockFreeLinkedQueue>("LockFreeLinkedQueue", trace, threads);
+	return 0;
+}
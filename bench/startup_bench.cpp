@@ -0,0 +1,98 @@
+#include <thread_pool/thread_pool.hpp>
+#include <thread_pool/queue/ring_blocking_queue.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+// Time from ThreadPool construction to the completion of its first task, eager vs lazy start.
+// usage: thread_pool_startup_bench [threads] [iterations]
+
+namespace
+{
+	using clock_type = std::chrono::steady_clock;
+
+	struct Sample
+	{
+		double first_task_us;
+		double total_us;
+	};
+
+	template<typename MakePool>
+	std::vector<Sample> measure(std::size_t iterations, MakePool make_pool)
+	{
+		std::vector<Sample> samples;
+		samples.reserve(iterations);
+		for(std::size_t i = 0; i < iterations; ++i)
+		{
+			const auto start = clock_type::now();
+			clock_type::time_point first_task;
+			{
+				auto pool = make_pool();
+				pool->enqueue([](){}).get();
+				first_task = clock_type::now();
+			}
+			const auto end = clock_type::now();
+
+			samples.push_back(Sample{
+				std::chrono::duration<double, std::micro>(first_task - start).count(),
+				std::chrono::duration<double, std::micro>(end - start).count()
+			});
+		}
+		return samples;
+	}
+
+	double percentile(std::vector<double> values, double fraction)
+	{
+		std::sort(values.begin(), values.end());
+		const auto index = static_cast<std::size_t>(fraction * static_cast<double>(values.size() - 1));
+		return values[index];
+	}
+
+	void report(const std::string& name, const std::vector<Sample>& samples)
+	{
+		std::vector<double> first_task;
+		std::vector<double> total;
+		for(const auto& sample: samples)
+		{
+			first_task.push_back(sample.first_task_us);
+			total.push_back(sample.total_us);
+		}
+
+		std::cout << name
+				<< "  first task p50 " << percentile(first_task, 0.5) << " us"
+				<< ", p90 " << percentile(first_task, 0.9) << " us"
+				<< "  |  with shutdown p50 " << percentile(total, 0.5) << " us"
+				<< ", p90 " << percentile(total, 0.9) << " us\n";
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const std::size_t threads = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : std::max(std::thread::hardware_concurrency(), 1u);
+	const std::size_t iterations = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 200;
+	if(threads == 0 || iterations == 0)
+	{
+		std::cerr << "usage: " << argv[0] << " [threads] [iterations]\n";
+		return 1;
+	}
+
+	using Pool = thread_pool::ThreadPool<thread_pool::RingBlockingQueue>;
+	constexpr std::size_t queue_size = 4096;
+
+	std::cout << threads << " threads, " << iterations << " iterations\n";
+	report("eager          ", measure(iterations, [&](){ return std::make_unique<Pool>(threads, 1, queue_size); }));
+	report("lazy           ", measure(iterations, [&](){ return std::make_unique<Pool>(thread_pool::lazy_start, threads, 1, queue_size); }));
+	report("lazy + reserve ", measure(iterations, [&](){
+		auto pool = std::make_unique<Pool>(thread_pool::lazy_start, threads, 1, queue_size);
+		pool->reserve(queue_size);
+		return pool;
+	}));
+	return 0;
+}
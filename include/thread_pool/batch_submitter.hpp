@@ -0,0 +1,269 @@
+#ifndef THREAD_POOL_BATCH_SUBMITTER_HPP
+#define THREAD_POOL_BATCH_SUBMITTER_HPP
+
+#include "detail/_bound_task.hpp"
+#include "detail/_task.hpp"
+#include "policy.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+
+namespace thread_pool
+{
+	struct BatchOptions
+	{
+		std::size_t min_batch = 1;
+		std::size_t max_batch = 256;
+		// an open batch is flushed at the latest after max_delay, zero disables the timer and leaves
+		// partial batches to flush() and the destructor
+		std::chrono::nanoseconds max_delay = std::chrono::microseconds(200);
+		// batch size is adjusted so that a chunk runs for about this long
+		std::chrono::nanoseconds target_chunk_time = std::chrono::microseconds(100);
+	};
+
+	/**
+	 * Coalesces small tasks into chunks which are enqueued to the pool as a single task.
+	 *
+	 * Every submitted task gets its own future. A batch is flushed when it reaches batch_size(),
+	 * when its oldest task waited max_delay, on flush() and on destruction. The timer thread is only
+	 * started by the first batch which is not flushed right away. Chunks measure
+	 * how long their tasks run and the batch size follows target_chunk_time / average task time,
+	 * so tiny tasks are batched aggressively and long ones go to the pool almost one by one.
+	 *
+	 * Meant for a single producer, concurrent submit() calls are safe but share one batch.
+	 * The pool has to outlive the submitter.
+	 */
+	template<typename Pool>
+	class BatchSubmitter
+	{
+	public:
+		explicit BatchSubmitter(Pool& pool, BatchOptions options = {});
+		~BatchSubmitter();
+
+		BatchSubmitter(const BatchSubmitter&) = delete;
+		BatchSubmitter& operator=(const BatchSubmitter&) = delete;
+
+		template<typename F, typename... Args>
+		requires std::invocable<std::decay_t<F>, std::decay_t<Args>...>
+		auto submit(F&& fun, Args&&... args) -> std::future<detail::task_result_t<F, Args...>>;
+
+		void flush();
+
+		[[nodiscard]] std::size_t batch_size() const;
+
+		/**
+		 * Moving average of a single task run time measured by the chunks, zero before the first one finished.
+		 */
+		[[nodiscard]] std::chrono::nanoseconds average_task_time() const noexcept;
+
+	private:
+		// shared with chunks still running after the submitter is gone
+		struct Feedback
+		{
+			std::atomic<std::int64_t> task_ns = 0;
+		};
+
+		Pool& pool_;
+		BatchOptions options_;
+		std::shared_ptr<Feedback> feedback_;
+
+		mutable std::mutex mutex_;
+		std::condition_variable timer_cv_;
+		std::vector<detail::Task> batch_;
+		std::chrono::steady_clock::time_point opened_at_;
+		std::size_t batch_size_;
+		bool stopping_ = false;
+		std::thread timer_;
+
+		std::vector<detail::Task> take_batch_locked();
+		void dispatch(std::vector<detail::Task> batch);
+		void timer_main();
+	};
+
+	template<typename Pool>
+	BatchSubmitter<Pool>::BatchSubmitter(Pool& pool, BatchOptions options)
+	:
+		pool_(pool),
+		options_(options),
+		feedback_(std::make_shared<Feedback>()),
+		batch_size_(options.min_batch)
+	{
+		if(options_.min_batch == 0 || options_.max_batch < options_.min_batch)
+		{
+			throw std::invalid_argument("Invalid batch size bounds");
+		}
+
+		batch_.reserve(options_.max_batch);
+	}
+
+	template<typename Pool>
+	BatchSubmitter<Pool>::~BatchSubmitter()
+	{
+		{
+			std::scoped_lock lock(mutex_);
+			stopping_ = true;
+		}
+		timer_cv_.notify_all();
+
+		if(timer_.joinable())
+		{
+			timer_.join();
+		}
+		flush();
+	}
+
+	template<typename Pool>
+	template<typename F, typename... Args>
+	requires std::invocable<std::decay_t<F>, std::decay_t<Args>...>
+	auto BatchSubmitter<Pool>::submit(F&& fun, Args&&... args) -> std::future<detail::task_result_t<F, Args...>>
+	{
+		std::vector<detail::Task> full_batch;
+		bool opened = false;
+
+		auto task_future = FutureResult::submit<detail::task_result_t<F, Args...>>(
+				[&]<typename T, typename... CtorArgs>(std::in_place_type_t<T>, CtorArgs&&... ctor_args)
+				{
+					std::scoped_lock lock(mutex_);
+
+					batch_.emplace_back(std::in_place_type<T>, std::forward<CtorArgs>(ctor_args)...);
+					if(batch_.size() == 1)
+					{
+						opened_at_ = std::chrono::steady_clock::now();
+						opened = true;
+					}
+					if(batch_.size() >= batch_size_)
+					{
+						full_batch = take_batch_locked();
+					}
+					else if(opened && options_.max_delay.count() > 0 && !timer_.joinable())
+					{
+						// it waits for the lock and then finds the open batch
+						timer_ = std::thread(&BatchSubmitter::timer_main, this);
+					}
+				},
+				std::forward<F>(fun),
+				std::forward<Args>(args)...
+		);
+
+		if(!full_batch.empty())
+		{
+			dispatch(std::move(full_batch));
+		}
+		else if(opened)
+		{
+			timer_cv_.notify_one();
+		}
+		return task_future;
+	}
+
+	template<typename Pool>
+	void BatchSubmitter<Pool>::flush()
+	{
+		std::vector<detail::Task> batch;
+		{
+			std::scoped_lock lock(mutex_);
+			batch = take_batch_locked();
+		}
+
+		if(!batch.empty())
+		{
+			dispatch(std::move(batch));
+		}
+	}
+
+	template<typename Pool>
+	std::size_t BatchSubmitter<Pool>::batch_size() const
+	{
+		std::scoped_lock lock(mutex_);
+		return batch_size_;
+	}
+
+	template<typename Pool>
+	std::chrono::nanoseconds BatchSubmitter<Pool>::average_task_time() const noexcept
+	{
+		return std::chrono::nanoseconds(feedback_->task_ns.load(std::memory_order_relaxed));
+	}
+
+	template<typename Pool>
+	std::vector<detail::Task> BatchSubmitter<Pool>::take_batch_locked()
+	{
+		// batch size for the next batch follows the latest measurement
+		const std::int64_t task_ns = feedback_->task_ns.load(std::memory_order_relaxed);
+		if(task_ns > 0)
+		{
+			const auto wanted = static_cast<std::size_t>(std::max<std::int64_t>(options_.target_chunk_time.count() / task_ns, 1));
+			batch_size_ = std::clamp(wanted, options_.min_batch, options_.max_batch);
+		}
+
+		std::vector<detail::Task> batch;
+		batch.reserve(batch_size_);
+		batch.swap(batch_);
+		return batch;
+	}
+
+	template<typename Pool>
+	void BatchSubmitter<Pool>::dispatch(std::vector<detail::Task> batch)
+	{
+		static_cast<void>(pool_.enqueue(
+				[tasks = std::move(batch), feedback = feedback_]() mutable
+				{
+					const auto start = std::chrono::steady_clock::now();
+					for(auto& task: tasks)
+					{
+						task();
+					}
+					const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+							std::chrono::steady_clock::now() - start
+					);
+
+					// exponential moving average, a lost update between concurrent chunks is harmless
+					const std::int64_t sample = std::max<std::int64_t>(elapsed.count() / static_cast<std::int64_t>(tasks.size()), 1);
+					const std::int64_t average = feedback->task_ns.load(std::memory_order_relaxed);
+					feedback->task_ns.store(
+							average == 0 ? sample : average + (sample - average) / 4,
+							std::memory_order_relaxed
+					);
+				}
+		));
+	}
+
+	template<typename Pool>
+	void BatchSubmitter<Pool>::timer_main()
+	{
+		std::unique_lock lock(mutex_);
+		while(!stopping_)
+		{
+			if(batch_.empty())
+			{
+				timer_cv_.wait(lock);
+				continue;
+			}
+
+			const auto deadline = opened_at_ + options_.max_delay;
+			if(std::chrono::steady_clock::now() < deadline)
+			{
+				timer_cv_.wait_until(lock, deadline);
+				continue;
+			}
+
+			std::vector<detail::Task> batch = take_batch_locked();
+			lock.unlock();
+			dispatch(std::move(batch));
+			lock.lock();
+		}
+	}
+}
+
+#endif //THREAD_POOL_BATCH_SUBMITTER_HPP
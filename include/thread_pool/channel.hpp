@@ -0,0 +1,398 @@
+#ifndef THREAD_POOL_CHANNEL_HPP
+#define THREAD_POOL_CHANNEL_HPP
+
+#include "detail/_select_waiter.hpp"
+#include "queue/common.hpp"
+#include "queue/naive_blocking_queue.hpp"
+#include "queue/ring_blocking_queue.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <condition_variable>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+
+
+namespace thread_pool
+{
+	/**
+	 * Go-style channel on top of a blocking queue, which can be waited on together with other
+	 * channels through select().
+	 *
+	 * A channel constructed with capacity 0 is a rendezvous channel: send() returns only after
+	 * a receiver took the value (or the channel was closed). Values sent before close() can still
+	 * be received afterwards.
+	 */
+	template<typename T, template<typename> class Q = RingBlockingQueue>
+	class BasicChannel
+	{
+	public:
+		using value_type = T;
+		using queue_type = Q<T>;
+
+		BasicChannel()
+		requires std::default_initializable<queue_type>;
+
+		/**
+		 * Capacity 0 creates a rendezvous channel.
+		 */
+		explicit BasicChannel(std::size_t capacity)
+		requires std::constructible_from<queue_type, std::size_t>;
+
+		BasicChannel(const BasicChannel&) = delete;
+		BasicChannel& operator=(const BasicChannel&) = delete;
+
+		[[nodiscard]] QueueOpStatus send(const value_type& value);
+		[[nodiscard]] QueueOpStatus send(value_type&& value);
+
+		/**
+		 * Never blocks on a full channel. A rendezvous channel accepts the value only when
+		 * a receiver is waiting, and then waits for the handoff.
+		 */
+		[[nodiscard]] QueueOpStatus try_send(const value_type& value);
+		[[nodiscard]] QueueOpStatus try_send(value_type&& value);
+
+		[[nodiscard]] QueueOpStatus receive(value_type& dest);
+		[[nodiscard]] QueueOpStatus try_receive(value_type& dest);
+
+		template<typename Rep, typename Period>
+		[[nodiscard]] QueueOpStatus receive_for(value_type& dest, const std::chrono::duration<Rep, Period>& timeout);
+
+		void close() noexcept;
+		[[nodiscard]] bool closed() const noexcept;
+
+		[[nodiscard]] bool rendezvous() const noexcept;
+
+		// select() internals
+		void add_waiter(detail::SelectWaiter* waiter);
+		void remove_waiter(detail::SelectWaiter* waiter);
+
+	private:
+		queue_type queue_;
+		bool rendezvous_ = false;
+
+		detail::WaiterList waiters_;
+		std::atomic<std::size_t> receivers_ = 0;
+
+		// rendezvous handoff, senders take turns
+		std::mutex send_mutex_;
+		std::mutex handoff_mutex_;
+		std::condition_variable handoff_cv_;
+		std::uint64_t received_ = 0;
+		bool handoff_closed_ = false;
+
+		template<typename U>
+		QueueOpStatus send_impl(U&& value);
+		template<typename U>
+		QueueOpStatus rendezvous_send(U&& value);
+
+		QueueOpStatus after_receive(QueueOpStatus status);
+	};
+
+	template<typename T>
+	using Channel = BasicChannel<T, RingBlockingQueue>;
+
+	template<typename T>
+	using UnboundedChannel = BasicChannel<T, NaiveBlockingQueue>;
+
+	struct SelectResult
+	{
+		static constexpr std::size_t no_channel = std::numeric_limits<std::size_t>::max();
+
+		// success, closed when all channels are closed and drained, timeout
+		QueueOpStatus status;
+		// position of the channel dest was received from
+		std::size_t index;
+	};
+
+	/**
+	 * Receives into dest from the first channel which has a value.
+	 */
+	template<typename T, template<typename> class... Qs>
+	requires (sizeof...(Qs) > 0)
+	SelectResult select(T& dest, BasicChannel<T, Qs>&... channels);
+
+	template<typename T, typename Clock, typename Duration, template<typename> class... Qs>
+	requires (sizeof...(Qs) > 0)
+	SelectResult select_until(
+			const std::chrono::time_point<Clock, Duration>& deadline,
+			T& dest,
+			BasicChannel<T, Qs>&... channels
+	);
+
+	template<typename T, template<typename> class Q>
+	BasicChannel<T, Q>::BasicChannel()
+	requires std::default_initializable<queue_type>
+	{}
+
+	template<typename T, template<typename> class Q>
+	BasicChannel<T, Q>::BasicChannel(std::size_t capacity)
+	requires std::constructible_from<queue_type, std::size_t>
+	:
+		queue_(capacity == 0 ? 1 : capacity),
+		rendezvous_(capacity == 0)
+	{}
+
+	template<typename T, template<typename> class Q>
+	QueueOpStatus BasicChannel<T, Q>::send(const value_type& value)
+	{
+		return rendezvous_ ? rendezvous_send(value) : send_impl(value);
+	}
+
+	template<typename T, template<typename> class Q>
+	QueueOpStatus BasicChannel<T, Q>::send(value_type&& value)
+	{
+		return rendezvous_ ? rendezvous_send(std::move(value)) : send_impl(std::move(value));
+	}
+
+	template<typename T, template<typename> class Q>
+	QueueOpStatus BasicChannel<T, Q>::try_send(const value_type& value)
+	{
+		if(rendezvous_)
+		{
+			return receivers_.load() == 0 ? QueueOpStatus::full : rendezvous_send(value);
+		}
+
+		const QueueOpStatus status = queue_.try_push(value);
+		if(status == QueueOpStatus::success)
+		{
+			waiters_.notify();
+		}
+		return status;
+	}
+
+	template<typename T, template<typename> class Q>
+	QueueOpStatus BasicChannel<T, Q>::try_send(value_type&& value)
+	{
+		if(rendezvous_)
+		{
+			return receivers_.load() == 0 ? QueueOpStatus::full : rendezvous_send(std::move(value));
+		}
+
+		const QueueOpStatus status = queue_.try_push(std::move(value));
+		if(status == QueueOpStatus::success)
+		{
+			waiters_.notify();
+		}
+		return status;
+	}
+
+	template<typename T, template<typename> class Q>
+	QueueOpStatus BasicChannel<T, Q>::receive(value_type& dest)
+	{
+		receivers_.fetch_add(1);
+		const QueueOpStatus status = queue_.wait_pop(dest);
+		receivers_.fetch_sub(1);
+
+		return after_receive(status);
+	}
+
+	template<typename T, template<typename> class Q>
+	QueueOpStatus BasicChannel<T, Q>::try_receive(value_type& dest)
+	{
+		return after_receive(queue_.try_pop(dest));
+	}
+
+	template<typename T, template<typename> class Q>
+	template<typename Rep, typename Period>
+	QueueOpStatus BasicChannel<T, Q>::receive_for(value_type& dest, const std::chrono::duration<Rep, Period>& timeout)
+	{
+		receivers_.fetch_add(1);
+		const QueueOpStatus status = queue_.wait_pop_for(dest, timeout);
+		receivers_.fetch_sub(1);
+
+		return after_receive(status);
+	}
+
+	template<typename T, template<typename> class Q>
+	void BasicChannel<T, Q>::close() noexcept
+	{
+		queue_.close();
+		{
+			std::scoped_lock lock(handoff_mutex_);
+			handoff_closed_ = true;
+		}
+		handoff_cv_.notify_all();
+		waiters_.notify();
+	}
+
+	template<typename T, template<typename> class Q>
+	bool BasicChannel<T, Q>::closed() const noexcept
+	{
+		return queue_.closed();
+	}
+
+	template<typename T, template<typename> class Q>
+	bool BasicChannel<T, Q>::rendezvous() const noexcept
+	{
+		return rendezvous_;
+	}
+
+	template<typename T, template<typename> class Q>
+	void BasicChannel<T, Q>::add_waiter(detail::SelectWaiter* waiter)
+	{
+		receivers_.fetch_add(1);
+		waiters_.add(waiter);
+	}
+
+	template<typename T, template<typename> class Q>
+	void BasicChannel<T, Q>::remove_waiter(detail::SelectWaiter* waiter)
+	{
+		waiters_.remove(waiter);
+		receivers_.fetch_sub(1);
+	}
+
+	template<typename T, template<typename> class Q>
+	template<typename U>
+	QueueOpStatus BasicChannel<T, Q>::send_impl(U&& value)
+	{
+		const QueueOpStatus status = queue_.wait_push(std::forward<U>(value));
+		if(status == QueueOpStatus::success)
+		{
+			waiters_.notify();
+		}
+		return status;
+	}
+
+	template<typename T, template<typename> class Q>
+	template<typename U>
+	QueueOpStatus BasicChannel<T, Q>::rendezvous_send(U&& value)
+	{
+		std::scoped_lock send_lock(send_mutex_);
+
+		std::uint64_t ticket;
+		{
+			std::scoped_lock lock(handoff_mutex_);
+			ticket = received_;
+		}
+
+		const QueueOpStatus status = send_impl(std::forward<U>(value));
+		if(status != QueueOpStatus::success)
+		{
+			return status;
+		}
+
+		std::unique_lock lock(handoff_mutex_);
+		handoff_cv_.wait(lock, [&](){ return received_ != ticket || handoff_closed_; });
+		return QueueOpStatus::success;
+	}
+
+	template<typename T, template<typename> class Q>
+	QueueOpStatus BasicChannel<T, Q>::after_receive(QueueOpStatus status)
+	{
+		if(status == QueueOpStatus::success && rendezvous_)
+		{
+			{
+				std::scoped_lock lock(handoff_mutex_);
+				++received_;
+			}
+			handoff_cv_.notify_all();
+		}
+		return status;
+	}
+
+	namespace detail
+	{
+		template<typename T, template<typename> class... Qs>
+		SelectResult try_select(T& dest, BasicChannel<T, Qs>&... channels)
+		{
+			std::size_t index = 0;
+			std::size_t closed = 0;
+			bool received = false;
+
+			const auto try_channel = [&](auto& channel)
+			{
+				const QueueOpStatus status = channel.try_receive(dest);
+				if(status == QueueOpStatus::success)
+				{
+					received = true;
+					return true;
+				}
+				closed += status == QueueOpStatus::closed;
+				++index;
+				return false;
+			};
+			(try_channel(channels) || ...);
+
+			if(received)
+			{
+				return SelectResult{QueueOpStatus::success, index};
+			}
+			if(closed == sizeof...(Qs))
+			{
+				return SelectResult{QueueOpStatus::closed, SelectResult::no_channel};
+			}
+			return SelectResult{QueueOpStatus::empty, SelectResult::no_channel};
+		}
+
+		template<typename T, typename Wait, template<typename> class... Qs>
+		SelectResult select_impl(Wait&& wait, T& dest, BasicChannel<T, Qs>&... channels)
+		{
+			SelectResult result = try_select(dest, channels...);
+			if(result.status != QueueOpStatus::empty)
+			{
+				return result;
+			}
+
+			SelectWaiter waiter;
+			(channels.add_waiter(&waiter), ...);
+
+			while(true)
+			{
+				result = try_select(dest, channels...);
+				if(result.status != QueueOpStatus::empty)
+				{
+					break;
+				}
+
+				std::unique_lock lock(waiter.mutex);
+				if(!wait(waiter.cv, lock, [&](){ return waiter.signaled; }))
+				{
+					result = SelectResult{QueueOpStatus::timeout, SelectResult::no_channel};
+					break;
+				}
+				waiter.signaled = false;
+			}
+
+			(channels.remove_waiter(&waiter), ...);
+			return result;
+		}
+	}
+
+	template<typename T, template<typename> class... Qs>
+	requires (sizeof...(Qs) > 0)
+	SelectResult select(T& dest, BasicChannel<T, Qs>&... channels)
+	{
+		return detail::select_impl(
+				[](std::condition_variable& cv, std::unique_lock<std::mutex>& lock, auto predicate)
+				{
+					cv.wait(lock, predicate);
+					return true;
+				},
+				dest,
+				channels...
+		);
+	}
+
+	template<typename T, typename Clock, typename Duration, template<typename> class... Qs>
+	requires (sizeof...(Qs) > 0)
+	SelectResult select_until(
+			const std::chrono::time_point<Clock, Duration>& deadline,
+			T& dest,
+			BasicChannel<T, Qs>&... channels
+	)
+	{
+		return detail::select_impl(
+				[&deadline](std::condition_variable& cv, std::unique_lock<std::mutex>& lock, auto predicate)
+				{
+					return cv.wait_until(lock, deadline, predicate);
+				},
+				dest,
+				channels...
+		);
+	}
+}
+
+#endif //THREAD_POOL_CHANNEL_HPP
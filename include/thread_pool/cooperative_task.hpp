@@ -0,0 +1,314 @@
+#ifndef THREAD_POOL_COOPERATIVE_TASK_HPP
+#define THREAD_POOL_COOPERATIVE_TASK_HPP
+
+// cooperative tasks need compiler coroutine support (GCC 10 only with -fcoroutines, not Clang 10 with libstdc++)
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#define THREAD_POOL_COOPERATIVE_TASKS
+
+#include "detail/_task.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+
+namespace thread_pool
+{
+	template<typename T = void>
+	class CooperativeTask;
+
+	namespace detail
+	{
+		// start of the time slice of the cooperative task running on this thread
+		inline thread_local std::chrono::steady_clock::time_point slice_start{};
+
+		/**
+		 * Coroutine frame which is at the same time the task pushed to the pool queues.
+		 *
+		 * Every Task holding the frame owns one reference, a yield adds one for the re-enqueued Task
+		 * before the running one is released, so the frame is destroyed by whichever Task lets go last.
+		 * Re-enqueueing therefore allocates nothing (unless metrics or context wrap the task).
+		 */
+		class CooperativePromiseBase: public TaskPimpl
+		{
+		public:
+			using reschedule_fn = bool (*)(void* pool, CooperativePromiseBase& task) noexcept;
+
+			std::suspend_always initial_suspend() noexcept
+			{
+				return {};
+			}
+
+			std::suspend_always final_suspend() noexcept
+			{
+				return {};
+			}
+
+			void invoke() final
+			{
+				slice_start = std::chrono::steady_clock::now();
+				handle_.resume();
+			}
+
+			void release() noexcept final
+			{
+				if(references_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				{
+					handle_.destroy();
+				}
+			}
+
+			void add_reference() noexcept
+			{
+				references_.fetch_add(1, std::memory_order_relaxed);
+			}
+
+			void bind(void* pool, reschedule_fn reschedule, std::shared_ptr<void> keep_alive) noexcept
+			{
+				pool_ = pool;
+				reschedule_ = reschedule;
+				keep_alive_ = std::move(keep_alive);
+			}
+
+			// false when the task could not be queued and has to keep running
+			bool reschedule() noexcept
+			{
+				return reschedule_ != nullptr && reschedule_(pool_, *this);
+			}
+
+		protected:
+			std::coroutine_handle<> handle_;
+
+		private:
+			std::atomic<std::size_t> references_ = 1;
+			void* pool_ = nullptr;
+			reschedule_fn reschedule_ = nullptr;
+			// callable and arguments the coroutine was created from, alive as long as the frame
+			std::shared_ptr<void> keep_alive_;
+		};
+
+		template<typename T>
+		class CooperativePromise: public CooperativePromiseBase
+		{
+		public:
+			CooperativeTask<T> get_return_object();
+
+			template<typename U>
+			requires std::convertible_to<U, T>
+			void return_value(U&& value)
+			{
+				result_.set_value(std::forward<U>(value));
+			}
+
+			void unhandled_exception()
+			{
+				result_.set_exception(std::current_exception());
+			}
+
+			std::future<T> get_future()
+			{
+				return result_.get_future();
+			}
+
+		private:
+			std::promise<T> result_;
+		};
+
+		template<>
+		class CooperativePromise<void>: public CooperativePromiseBase
+		{
+		public:
+			CooperativeTask<void> get_return_object();
+
+			void return_void()
+			{
+				result_.set_value();
+			}
+
+			void unhandled_exception()
+			{
+				result_.set_exception(std::current_exception());
+			}
+
+			std::future<void> get_future()
+			{
+				return result_.get_future();
+			}
+
+		private:
+			std::promise<void> result_;
+		};
+
+		template<typename T>
+		struct is_cooperative_task: std::false_type
+		{};
+
+		template<typename T>
+		struct is_cooperative_task<CooperativeTask<T>>: std::true_type
+		{};
+	}
+
+	/**
+	 * Coroutine which runs on a pool in time slices, submitted with ThreadPool::enqueue_cooperative.
+	 *
+	 * Inside, co_await this_task::yield() puts the task at the back of the pool queue and frees
+	 * the worker for the tasks waiting behind it; this_task::maybe_yield(slice) does so only once
+	 * the current slice ran longer than slice. The coroutine starts suspended and is destroyed
+	 * without running if it is never submitted.
+	 */
+	template<typename T>
+	class CooperativeTask
+	{
+	public:
+		using promise_type = detail::CooperativePromise<T>;
+		using value_type = T;
+
+		CooperativeTask(CooperativeTask&& other) noexcept
+		:
+			handle_(std::exchange(other.handle_, nullptr))
+		{}
+
+		CooperativeTask& operator=(CooperativeTask&& other) noexcept
+		{
+			if(this != &other)
+			{
+				reset();
+				handle_ = std::exchange(other.handle_, nullptr);
+			}
+			return *this;
+		}
+
+		~CooperativeTask()
+		{
+			reset();
+		}
+
+		/**
+		 * Hands the reference to the frame over to the caller (the pool), the task becomes empty.
+		 */
+		promise_type* detach() noexcept
+		{
+			promise_type* promise = handle_ ? &handle_.promise() : nullptr;
+			handle_ = nullptr;
+			return promise;
+		}
+
+	private:
+		friend promise_type;
+
+		explicit CooperativeTask(std::coroutine_handle<promise_type> handle) noexcept
+		:
+			handle_(handle)
+		{}
+
+		void reset() noexcept
+		{
+			if(handle_)
+			{
+				handle_.promise().release();
+				handle_ = nullptr;
+			}
+		}
+
+		std::coroutine_handle<promise_type> handle_;
+	};
+
+	template<typename T>
+	CooperativeTask<T> detail::CooperativePromise<T>::get_return_object()
+	{
+		auto handle = std::coroutine_handle<CooperativePromise<T>>::from_promise(*this);
+		handle_ = handle;
+		return CooperativeTask<T>(handle);
+	}
+
+	inline CooperativeTask<void> detail::CooperativePromise<void>::get_return_object()
+	{
+		auto handle = std::coroutine_handle<CooperativePromise<void>>::from_promise(*this);
+		handle_ = handle;
+		return CooperativeTask<void>(handle);
+	}
+
+	namespace this_task
+	{
+		inline constexpr std::chrono::microseconds default_time_slice{1000};
+
+		class YieldAwaiter
+		{
+		public:
+			explicit YieldAwaiter(bool ready) noexcept
+			:
+				ready_(ready)
+			{}
+
+			[[nodiscard]] bool await_ready() const noexcept
+			{
+				return ready_;
+			}
+
+			// the frame may already run on another worker once reschedule() returned true
+			template<typename Promise>
+			requires std::derived_from<Promise, detail::CooperativePromiseBase>
+			bool await_suspend(std::coroutine_handle<Promise> handle) noexcept
+			{
+				return handle.promise().reschedule();
+			}
+
+			void await_resume() const noexcept
+			{}
+
+		private:
+			bool ready_;
+		};
+
+		/**
+		 * Re-enqueues the running cooperative task behind the tasks already queued.
+		 */
+		[[nodiscard]] inline YieldAwaiter yield() noexcept
+		{
+			return YieldAwaiter(false);
+		}
+
+		/**
+		 * Yields only if the current time slice is longer than slice, cheap enough for inner loops.
+		 */
+		[[nodiscard]] inline YieldAwaiter maybe_yield(std::chrono::nanoseconds slice = default_time_slice) noexcept
+		{
+			return YieldAwaiter(std::chrono::steady_clock::now() - detail::slice_start < slice);
+		}
+	}
+
+	namespace detail
+	{
+		// keeps the callable and arguments of a coroutine alive as long as its frame
+		template<typename F, typename... Args>
+		struct CooperativeCall
+		{
+			template<typename FF, typename... AArgs>
+			explicit CooperativeCall(FF&& fun, AArgs&&... args)
+			:
+				fun(std::forward<FF>(fun)),
+				args(std::forward<AArgs>(args)...)
+			{}
+
+			auto call()
+			{
+				return std::apply([this](auto&... stored){ return std::invoke(fun, stored...); }, args);
+			}
+
+			F fun;
+			std::tuple<Args...> args;
+		};
+	}
+}
+
+#endif
+
+#endif //THREAD_POOL_COOPERATIVE_TASK_HPP
@@ -0,0 +1,111 @@
+#ifndef THREAD_POOL__BOUND_TASK_HPP
+#define THREAD_POOL__BOUND_TASK_HPP
+
+#include <exception>
+#include <functional>
+#include <future>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+
+namespace thread_pool::detail
+{
+	// result reported for fun(args...) invoked with decayed arguments, rvalue references are returned by value
+	template<typename F, typename... Args>
+	using task_result_t = std::conditional_t<
+			std::is_rvalue_reference_v<std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>>,
+			std::remove_reference_t<std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>>,
+			std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>
+	>;
+
+	/**
+	 * Callable and its arguments stored by value (decayed, like std::thread and std::async do)
+	 * and invoked once through std::invoke with the stored values passed as rvalues.
+	 */
+	template<typename F, typename... Args>
+	class BoundCall
+	{
+	public:
+		using result_type = std::invoke_result_t<F, Args...>;
+
+		template<typename FF, typename... AArgs>
+		explicit BoundCall(FF&& fun, AArgs&&... args)
+		:
+			fun_(std::forward<FF>(fun)),
+			args_(std::forward<AArgs>(args)...)
+		{}
+
+		result_type operator()()
+		{
+			return std::apply(
+					[this](Args&... args) -> result_type
+					{
+						return std::invoke(std::move(fun_), std::move(args)...);
+					},
+					args_
+			);
+		}
+
+	private:
+		F fun_;
+		std::tuple<Args...> args_;
+	};
+
+	template<typename R, typename F, typename... Args>
+	class PromiseTask
+	{
+	public:
+		template<typename... CallArgs>
+		explicit PromiseTask(std::promise<R>&& promise, CallArgs&&... call_args)
+		:
+			promise_(std::move(promise)),
+			call_(std::forward<CallArgs>(call_args)...)
+		{}
+
+		void operator()()
+		{
+			try
+			{
+				if constexpr(std::is_void_v<R>)
+				{
+					call_();
+					promise_.set_value();
+				}
+				else
+				{
+					promise_.set_value(call_());
+				}
+			}
+			catch(...)
+			{
+				promise_.set_exception(std::current_exception());
+			}
+		}
+
+	private:
+		std::promise<R> promise_;
+		BoundCall<F, Args...> call_;
+	};
+
+	template<typename F, typename... Args>
+	class DetachedTask
+	{
+	public:
+		template<typename... CallArgs>
+		explicit DetachedTask(CallArgs&&... call_args)
+		:
+			call_(std::forward<CallArgs>(call_args)...)
+		{}
+
+		void operator()()
+		{
+			static_cast<void>(call_());
+		}
+
+	private:
+		BoundCall<F, Args...> call_;
+	};
+}
+
+#endif //THREAD_POOL__BOUND_TASK_HPP
@@ -0,0 +1,31 @@
+#ifndef THREAD_POOL__JUMP_HASH_HPP
+#define THREAD_POOL__JUMP_HASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace thread_pool::detail
+{
+	/**
+	 * Jump consistent hash (Lamping, Veach): maps key to one of buckets buckets.
+	 *
+	 * Growing from n to n + 1 buckets moves only about 1 / (n + 1) of the keys, all of them to the new bucket.
+	 */
+	constexpr std::size_t jump_hash(std::uint64_t key, std::size_t buckets) noexcept
+	{
+		std::int64_t bucket = -1;
+		std::int64_t next = 0;
+		while(next < static_cast<std::int64_t>(buckets))
+		{
+			bucket = next;
+			key = key * 2862933555777941757ULL + 1;
+			next = static_cast<std::int64_t>(
+					static_cast<double>(bucket + 1) * (static_cast<double>(1LL << 31) / static_cast<double>((key >> 33) + 1))
+			);
+		}
+		return static_cast<std::size_t>(bucket);
+	}
+}
+
+#endif //THREAD_POOL__JUMP_HASH_HPP
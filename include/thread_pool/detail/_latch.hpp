@@ -0,0 +1,54 @@
+#ifndef THREAD_POOL__LATCH_HPP
+#define THREAD_POOL__LATCH_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+
+namespace thread_pool::detail
+{
+	/**
+	 * Single use countdown with the std::latch interface, which libstdc++ 10 does not provide.
+	 */
+	class Latch
+	{
+	public:
+		explicit Latch(std::ptrdiff_t count)
+		:
+			count_(count)
+		{}
+
+		Latch(const Latch&) = delete;
+		Latch& operator=(const Latch&) = delete;
+
+		void count_down(std::ptrdiff_t update = 1)
+		{
+			std::scoped_lock lock(mutex_);
+			count_ -= update;
+			if(count_ <= 0)
+			{
+				released_.notify_all();
+			}
+		}
+
+		void wait()
+		{
+			std::unique_lock lock(mutex_);
+			released_.wait(lock, [this](){ return count_ <= 0; });
+		}
+
+		void arrive_and_wait(std::ptrdiff_t update = 1)
+		{
+			count_down(update);
+			wait();
+		}
+
+	private:
+		std::mutex mutex_;
+		std::condition_variable released_;
+		std::ptrdiff_t count_;
+	};
+}
+
+#endif //THREAD_POOL__LATCH_HPP
@@ -0,0 +1,141 @@
+#ifndef THREAD_POOL__MAP_REDUCE_HPP
+#define THREAD_POOL__MAP_REDUCE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+
+namespace thread_pool::detail
+{
+	/**
+	 * State of a single map_reduce call shared by its chunk tasks.
+	 *
+	 * Worker i accumulates into its own cache-line-padded slot without synchronization, the last
+	 * slot is shared (under a mutex) by threads with an index outside of the pool's regular workers.
+	 * The chunk finishing last combines the slots and fulfils the promise.
+	 */
+	template<typename T, typename Map, typename Combine>
+	class MapReduceJob
+	{
+	public:
+		MapReduceJob(std::size_t worker_slots, std::size_t chunks, T init, Map map, Combine combine)
+		:
+			slots_(worker_slots + 1),
+			accumulators_(std::make_unique<Accumulator[]>(slots_)),
+			remaining_(chunks),
+			init_(std::move(init)),
+			map_(std::move(map)),
+			combine_(std::move(combine))
+		{}
+
+		std::future<T> get_future()
+		{
+			return promise_.get_future();
+		}
+
+		void run_chunk(std::size_t worker, std::size_t begin, std::size_t end)
+		{
+			if(!failed_.load(std::memory_order_relaxed))
+			{
+				try
+				{
+					if(worker < slots_ - 1)
+					{
+						accumulate(accumulators_[worker], begin, end);
+					}
+					else
+					{
+						std::scoped_lock lock(overflow_mutex_);
+						accumulate(accumulators_[slots_ - 1], begin, end);
+					}
+				}
+				catch(...)
+				{
+					fail(std::current_exception());
+				}
+			}
+
+			if(remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				finish();
+			}
+		}
+
+	private:
+		struct alignas(64) Accumulator
+		{
+			std::optional<T> value;
+		};
+
+		std::size_t slots_;
+		std::unique_ptr<Accumulator[]> accumulators_;
+		std::mutex overflow_mutex_;
+
+		std::atomic<std::size_t> remaining_;
+		std::atomic<bool> failed_ = false;
+		std::exception_ptr error_;
+
+		T init_;
+		Map map_;
+		Combine combine_;
+		std::promise<T> promise_;
+
+		void accumulate(Accumulator& accumulator, std::size_t begin, std::size_t end)
+		{
+			for(std::size_t index = begin; index < end; ++index)
+			{
+				if(accumulator.value)
+				{
+					accumulator.value = combine_(std::move(*accumulator.value), map_(index));
+				}
+				else
+				{
+					accumulator.value.emplace(map_(index));
+				}
+			}
+		}
+
+		void fail(std::exception_ptr error)
+		{
+			// only the first failure is reported, the acq_rel on remaining_ publishes error_ to finish()
+			if(!failed_.exchange(true, std::memory_order_relaxed))
+			{
+				error_ = std::move(error);
+			}
+		}
+
+		void finish()
+		{
+			if(failed_.load(std::memory_order_relaxed))
+			{
+				promise_.set_exception(error_);
+				return;
+			}
+
+			try
+			{
+				T result = std::move(init_);
+				for(std::size_t slot = 0; slot < slots_; ++slot)
+				{
+					if(accumulators_[slot].value)
+					{
+						result = combine_(std::move(result), std::move(*accumulators_[slot].value));
+					}
+				}
+				promise_.set_value(std::move(result));
+			}
+			catch(...)
+			{
+				promise_.set_exception(std::current_exception());
+			}
+		}
+	};
+}
+
+#endif //THREAD_POOL__MAP_REDUCE_HPP
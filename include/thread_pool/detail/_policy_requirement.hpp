@@ -0,0 +1,69 @@
+#ifndef THREAD_POOL__POLICY_REQUIREMENT_HPP
+#define THREAD_POOL__POLICY_REQUIREMENT_HPP
+
+#include "thread_pool/policy.hpp"
+
+#include <concepts>
+#include <cstddef>
+
+
+namespace thread_pool::detail
+{
+	using policy_test_function = void(*)();
+
+	template<typename Metrics>
+	concept pool_metrics = requires
+	{
+		{ Metrics::enabled } -> std::convertible_to<bool>;
+	}
+	&& (
+		!Metrics::enabled
+		|| requires(Metrics metrics, typename Metrics::task_token token, TaskLabel label, std::size_t index)
+		{
+			{ metrics.on_enqueue(label) } -> std::same_as<typename Metrics::task_token>;
+			metrics.on_task_start(token, index);
+			metrics.on_task_end(token, index);
+		}
+	);
+
+	template<typename Context>
+	concept task_context = requires
+	{
+		{ Context::enabled } -> std::convertible_to<bool>;
+	}
+	&& (
+		!Context::enabled
+		|| requires
+		{
+			typename Context::scope;
+			requires std::constructible_from<typename Context::scope, decltype(Context::capture())>;
+		}
+	);
+
+	template<typename Policy>
+	concept pool_policy = pool_metrics<typename Policy::metrics> && task_context<typename Policy::context> && requires(
+			typename Policy::thread_factory thread_factory,
+			std::size_t index,
+			policy_test_function fun
+	)
+	{
+		typename Policy::task_type;
+		typename Policy::wait_strategy;
+		typename Policy::result_policy;
+
+		requires std::default_initializable<typename Policy::task_type>;
+		requires std::movable<typename Policy::task_type>;
+		requires std::constructible_from<typename Policy::task_type, policy_test_function>;
+		requires std::invocable<typename Policy::task_type&>;
+
+		typename Policy::worker_state;
+		requires std::default_initializable<typename Policy::worker_state>
+				|| std::constructible_from<typename Policy::worker_state, std::size_t>;
+
+		typename Policy::thread_factory::thread_type;
+		{ thread_factory.create(index, fun) } -> std::same_as<typename Policy::thread_factory::thread_type>;
+		thread_factory.create(index, fun).join();
+	};
+}
+
+#endif //THREAD_POOL__POLICY_REQUIREMENT_HPP
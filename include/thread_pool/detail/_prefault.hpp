@@ -0,0 +1,28 @@
+#ifndef THREAD_POOL__PREFAULT_HPP
+#define THREAD_POOL__PREFAULT_HPP
+
+#include <cstddef>
+
+
+namespace thread_pool::detail
+{
+	/**
+	 * Touches every page of raw (not yet constructed) storage, so later writes do not page fault.
+	 */
+	inline void prefault(void* storage, std::size_t bytes) noexcept
+	{
+		constexpr std::size_t page_size = 4096;
+
+		auto* bytes_begin = static_cast<volatile unsigned char*>(storage);
+		for(std::size_t offset = 0; offset < bytes; offset += page_size)
+		{
+			bytes_begin[offset] = 0;
+		}
+		if(bytes != 0)
+		{
+			bytes_begin[bytes - 1] = 0;
+		}
+	}
+}
+
+#endif //THREAD_POOL__PREFAULT_HPP
@@ -0,0 +1,57 @@
+#ifndef THREAD_POOL__QUEUE_COUNTERS_HPP
+#define THREAD_POOL__QUEUE_COUNTERS_HPP
+
+#include "thread_pool/queue/common.hpp"
+
+#include <atomic>
+#include <cstddef>
+
+
+namespace thread_pool::detail
+{
+	/**
+	 * Relaxed mirror of a locked queue's depth, high-water mark and closed flag.
+	 *
+	 * Updated only while the queue lock is held, so plain load/store is enough for the writers;
+	 * readers get a lock-free but possibly slightly stale snapshot.
+	 */
+	class QueueCounters
+	{
+	public:
+		void on_push() noexcept
+		{
+			const std::size_t size = size_.load(std::memory_order_relaxed) + 1;
+			size_.store(size, std::memory_order_relaxed);
+			if(size > high_water_mark_.load(std::memory_order_relaxed))
+			{
+				high_water_mark_.store(size, std::memory_order_relaxed);
+			}
+		}
+
+		void on_pop() noexcept
+		{
+			size_.store(size_.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+		}
+
+		void on_close() noexcept
+		{
+			closed_.store(true, std::memory_order_relaxed);
+		}
+
+		[[nodiscard]] QueueStats snapshot() const noexcept
+		{
+			return QueueStats{
+				size_.load(std::memory_order_relaxed),
+				high_water_mark_.load(std::memory_order_relaxed),
+				closed_.load(std::memory_order_relaxed)
+			};
+		}
+
+	private:
+		std::atomic<std::size_t> size_ = 0;
+		std::atomic<std::size_t> high_water_mark_ = 0;
+		std::atomic<bool> closed_ = false;
+	};
+}
+
+#endif //THREAD_POOL__QUEUE_COUNTERS_HPP
@@ -4,6 +4,7 @@
 #include "thread_pool/queue/common.hpp"
 
 #include <concepts>
+#include <chrono>
 
 
 namespace thread_pool::detail
@@ -28,6 +29,12 @@ namespace thread_pool::detail
 		{ a.wait_push(std::move(tmp_value)) } -> std::same_as<QueueOpStatus>;
 		{ a.wait_pop(value) } -> std::same_as<QueueOpStatus>;
 
+		{ a.wait_push_for(std::move(tmp_value), std::chrono::milliseconds{}) } -> std::same_as<QueueOpStatus>;
+		{ a.wait_pop_for(value, std::chrono::milliseconds{}) } -> std::same_as<QueueOpStatus>;
+
+		{ a.wait_push_until(std::move(tmp_value), std::chrono::steady_clock::now()) } -> std::same_as<QueueOpStatus>;
+		{ a.wait_pop_until(value, std::chrono::steady_clock::now()) } -> std::same_as<QueueOpStatus>;
+
 		a.close();
 		{ b.closed() } -> std::same_as<bool>;
 
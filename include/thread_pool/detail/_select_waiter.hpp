@@ -0,0 +1,82 @@
+#ifndef THREAD_POOL__SELECT_WAITER_HPP
+#define THREAD_POOL__SELECT_WAITER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+
+namespace thread_pool::detail
+{
+	/**
+	 * Wakeup flag shared by all channels a select waits on.
+	 */
+	struct SelectWaiter
+	{
+		std::mutex mutex;
+		std::condition_variable cv;
+		bool signaled = false;
+
+		void notify()
+		{
+			{
+				std::scoped_lock lock(mutex);
+				signaled = true;
+			}
+			cv.notify_one();
+		}
+	};
+
+	/**
+	 * Select waiters registered on a single channel.
+	 *
+	 * Registration has to happen before the channel is checked for data, notify() has to follow
+	 * publishing the data under the queue lock. The queue lock orders both, so a waiter is either
+	 * seen by notify() or sees the data itself.
+	 */
+	class WaiterList
+	{
+	public:
+		void add(SelectWaiter* waiter)
+		{
+			std::scoped_lock lock(mutex_);
+			waiters_.push_back(waiter);
+			count_.store(waiters_.size(), std::memory_order_relaxed);
+		}
+
+		void remove(SelectWaiter* waiter)
+		{
+			std::scoped_lock lock(mutex_);
+			std::erase(waiters_, waiter);
+			count_.store(waiters_.size(), std::memory_order_relaxed);
+		}
+
+		void notify()
+		{
+			if(count_.load(std::memory_order_relaxed) == 0)
+			{
+				return;
+			}
+
+			std::scoped_lock lock(mutex_);
+			for(SelectWaiter* waiter: waiters_)
+			{
+				waiter->notify();
+			}
+		}
+
+		[[nodiscard]] std::size_t size() const noexcept
+		{
+			return count_.load(std::memory_order_relaxed);
+		}
+
+	private:
+		std::mutex mutex_;
+		std::vector<SelectWaiter*> waiters_;
+		std::atomic<std::size_t> count_ = 0;
+	};
+}
+
+#endif //THREAD_POOL__SELECT_WAITER_HPP
@@ -1,6 +1,11 @@
 #ifndef THREAD_POOL__TASK_HPP
 #define THREAD_POOL__TASK_HPP
 
+#include <memory>
+#include <concepts>
+#include <type_traits>
+#include <utility>
+
 
 namespace thread_pool::detail
 {
@@ -8,6 +13,13 @@ namespace thread_pool::detail
 	{
 	public:
 		virtual void invoke() = 0;
+
+		// called by the owning Task, implementations not allocated by Task manage their own lifetime
+		virtual void release() noexcept
+		{
+			delete this;
+		}
+
 		virtual ~TaskPimpl() = default;
 	};
 
@@ -20,6 +32,12 @@ namespace thread_pool::detail
 			fun_(std::move(fun))
 		{};
 
+		template<typename... CtorArgs>
+		explicit TaskPimplImpl(std::in_place_t, CtorArgs&&... ctor_args)
+		:
+			fun_(std::forward<CtorArgs>(ctor_args)...)
+		{}
+
 		void invoke() final
 		{
 			fun_();
@@ -38,26 +56,51 @@ namespace thread_pool::detail
 		Task& operator=(Task&&) = default;
 
 		template<typename F>
-		requires (!std::same_as<std::decay_t<F>, Task>)
+		requires (!std::same_as<std::decay_t<F>, Task>) && std::invocable<std::decay_t<F>&>
 		Task(F&& fun)
 		:
 			pimpl_(make_pimpl(std::forward<F>(fun)))
 		{}
 
+		// constructs callable of type F directly in the task storage
+		template<typename F, typename... CtorArgs>
+		explicit Task(std::in_place_type_t<F>, CtorArgs&&... ctor_args)
+		:
+			pimpl_(new TaskPimplImpl<F>(std::in_place, std::forward<CtorArgs>(ctor_args)...))
+		{}
+
+		/**
+		 * Takes over a reference to an externally managed implementation, released through TaskPimpl::release().
+		 */
+		static Task adopt(TaskPimpl* pimpl) noexcept
+		{
+			Task task;
+			task.pimpl_.reset(pimpl);
+			return task;
+		}
+
 		void operator()()
 		{
 			pimpl_->invoke();
 		}
 
 	private:
-		std::unique_ptr<TaskPimpl> pimpl_;
+		struct Release
+		{
+			void operator()(TaskPimpl* pimpl) const noexcept
+			{
+				pimpl->release();
+			}
+		};
+
+		std::unique_ptr<TaskPimpl, Release> pimpl_;
 
 		template<typename FF>
 		static auto make_pimpl(FF&& fun)
 		{
 			using decay_FF = std::decay_t<FF>;
 			using impl_t = TaskPimplImpl<decay_FF>;
-			return std::make_unique<impl_t>(std::forward<FF>(fun));
+			return std::unique_ptr<TaskPimpl, Release>(new impl_t(std::forward<FF>(fun)));
 		}
 	};
 }
@@ -0,0 +1,21 @@
+#ifndef THREAD_POOL__WORKER_CONTEXT_HPP
+#define THREAD_POOL__WORKER_CONTEXT_HPP
+
+#include <cstddef>
+
+
+namespace thread_pool::detail
+{
+	struct WorkerContext
+	{
+		const void* pool = nullptr;
+		const void* pool_type = nullptr;
+		std::size_t index = 0;
+		void* state = nullptr;
+	};
+
+	// set by pool workers for the lifetime of the thread, pool is null outside of them
+	inline thread_local WorkerContext this_worker;
+}
+
+#endif //THREAD_POOL__WORKER_CONTEXT_HPP
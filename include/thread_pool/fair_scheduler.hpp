@@ -0,0 +1,350 @@
+#ifndef THREAD_POOL_FAIR_SCHEDULER_HPP
+#define THREAD_POOL_FAIR_SCHEDULER_HPP
+
+#include "detail/_bound_task.hpp"
+#include "detail/_task.hpp"
+#include "policy.hpp"
+#include "queue/common.hpp"
+
+#include <concepts>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace thread_pool
+{
+	class ChannelFullException: public QueueException {};
+
+	struct ChannelOptions
+	{
+		static constexpr std::size_t unlimited = std::numeric_limits<std::size_t>::max();
+
+		std::size_t weight = 1;
+		std::size_t max_concurrency = unlimited;
+		std::size_t max_depth = unlimited;
+	};
+
+	struct ChannelStats
+	{
+		std::string name;
+		std::size_t weight;
+		std::size_t queued;
+		std::size_t running;
+		std::size_t submitted;
+		std::size_t completed;
+		// refused at max_depth or dropped because the pool did not accept them
+		std::size_t rejected;
+	};
+
+	/**
+	 * Fair scheduling of tasks from several named submission channels onto one pool.
+	 *
+	 * Each channel has its own FIFO. Tasks are released to the pool by deficit round-robin:
+	 * a channel gets weight tasks per round, as long as it stays below its concurrency cap.
+	 * At most max_in_flight tasks are handed to the pool at once, so a flooding channel cannot
+	 * fill the pool queue and starve the others. Submission to a channel at max_depth is rejected.
+	 * Tasks the pool refuses (e.g. because its queues are closed) are dropped, their futures report
+	 * std::future_errc::broken_promise.
+	 *
+	 * Destructor waits until all submitted tasks have finished. The pool has to outlive the scheduler.
+	 */
+	template<typename Pool>
+	class FairScheduler
+	{
+	public:
+		using channel_id = std::size_t;
+
+		explicit FairScheduler(Pool& pool);
+		FairScheduler(Pool& pool, std::size_t max_in_flight);
+		~FairScheduler();
+
+		FairScheduler(const FairScheduler&) = delete;
+		FairScheduler& operator=(const FairScheduler&) = delete;
+
+		channel_id add_channel(std::string name, ChannelOptions options = {});
+
+		/**
+		 * Throws ChannelFullException when the channel already holds max_depth queued tasks.
+		 * Callable and arguments are decay-copied into the queued task like by ThreadPool::enqueue.
+		 */
+		template<typename F, typename... Args>
+		requires std::invocable<std::decay_t<F>, std::decay_t<Args>...>
+		auto submit(channel_id channel, F&& fun, Args&&... args) -> std::future<detail::task_result_t<F, Args...>>;
+
+		[[nodiscard]] std::vector<ChannelStats> stats() const;
+
+	private:
+		struct Channel
+		{
+			std::string name;
+			ChannelOptions options;
+			std::deque<detail::Task> pending;
+			std::size_t deficit = 0;
+			std::size_t running = 0;
+			std::size_t submitted = 0;
+			std::size_t completed = 0;
+			std::size_t rejected = 0;
+		};
+
+		Pool& pool_;
+		std::size_t max_in_flight_;
+
+		mutable std::mutex mutex_;
+		std::condition_variable idle_cv_;
+		std::vector<std::unique_ptr<Channel>> channels_;
+		std::size_t cursor_ = 0;
+		std::size_t in_flight_ = 0;
+		std::size_t queued_ = 0;
+
+		bool eligible(const Channel& channel) const noexcept;
+		std::vector<std::pair<channel_id, detail::Task>> select_locked();
+		void dispatch(std::vector<std::pair<channel_id, detail::Task>> selected);
+		std::vector<std::pair<channel_id, detail::Task>> drop_locked(const std::vector<std::pair<channel_id, detail::Task>>& dropped);
+		void on_complete(channel_id channel);
+	};
+
+	template<typename Pool>
+	FairScheduler<Pool>::FairScheduler(Pool& pool)
+	:
+		FairScheduler(pool, pool.thread_count())
+	{}
+
+	template<typename Pool>
+	FairScheduler<Pool>::FairScheduler(Pool& pool, std::size_t max_in_flight)
+	:
+		pool_(pool),
+		max_in_flight_(max_in_flight)
+	{
+		if(max_in_flight == 0)
+		{
+			throw std::invalid_argument("FairScheduler needs at least one task in flight");
+		}
+	}
+
+	template<typename Pool>
+	FairScheduler<Pool>::~FairScheduler()
+	{
+		std::unique_lock lock(mutex_);
+		idle_cv_.wait(
+				lock,
+				[this]()
+				{
+					return in_flight_ == 0 && queued_ == 0;
+				}
+		);
+	}
+
+	template<typename Pool>
+	typename FairScheduler<Pool>::channel_id FairScheduler<Pool>::add_channel(std::string name, ChannelOptions options)
+	{
+		if(options.weight == 0 || options.max_concurrency == 0)
+		{
+			throw std::invalid_argument("Channel weight and concurrency must be positive");
+		}
+
+		std::scoped_lock lock(mutex_);
+		auto channel = std::make_unique<Channel>();
+		channel->name = std::move(name);
+		channel->options = options;
+
+		channels_.push_back(std::move(channel));
+		return channels_.size() - 1;
+	}
+
+	template<typename Pool>
+	template<typename F, typename... Args>
+	requires std::invocable<std::decay_t<F>, std::decay_t<Args>...>
+	auto FairScheduler<Pool>::submit(channel_id channel, F&& fun, Args&&... args)
+			-> std::future<detail::task_result_t<F, Args...>>
+	{
+		std::vector<std::pair<channel_id, detail::Task>> selected;
+
+		auto task_future = FutureResult::submit<detail::task_result_t<F, Args...>>(
+				[&]<typename T, typename... CtorArgs>(std::in_place_type_t<T>, CtorArgs&&... ctor_args)
+				{
+					std::scoped_lock lock(mutex_);
+					auto& target = *channels_.at(channel);
+					if(target.pending.size() >= target.options.max_depth)
+					{
+						++target.rejected;
+						throw ChannelFullException();
+					}
+
+					target.pending.emplace_back(std::in_place_type<T>, std::forward<CtorArgs>(ctor_args)...);
+					++target.submitted;
+					++queued_;
+
+					selected = select_locked();
+				},
+				std::forward<F>(fun),
+				std::forward<Args>(args)...
+		);
+		dispatch(std::move(selected));
+
+		return task_future;
+	}
+
+	template<typename Pool>
+	std::vector<ChannelStats> FairScheduler<Pool>::stats() const
+	{
+		std::scoped_lock lock(mutex_);
+
+		std::vector<ChannelStats> result;
+		result.reserve(channels_.size());
+		for(const auto& channel: channels_)
+		{
+			result.push_back(
+					ChannelStats{
+						channel->name,
+						channel->options.weight,
+						channel->pending.size(),
+						channel->running,
+						channel->submitted,
+						channel->completed,
+						channel->rejected
+					}
+			);
+		}
+		return result;
+	}
+
+	template<typename Pool>
+	bool FairScheduler<Pool>::eligible(const Channel& channel) const noexcept
+	{
+		return !channel.pending.empty() && channel.running < channel.options.max_concurrency;
+	}
+
+	template<typename Pool>
+	std::vector<std::pair<typename FairScheduler<Pool>::channel_id, detail::Task>> FairScheduler<Pool>::select_locked()
+	{
+		std::vector<std::pair<channel_id, detail::Task>> selected;
+
+		std::size_t skipped = 0;
+		while(in_flight_ < max_in_flight_ && skipped < channels_.size())
+		{
+			auto& channel = *channels_[cursor_];
+			if(!eligible(channel))
+			{
+				// empty channels do not keep their credit
+				if(channel.pending.empty())
+				{
+					channel.deficit = 0;
+				}
+				cursor_ = (cursor_ + 1) % channels_.size();
+				++skipped;
+				continue;
+			}
+
+			if(channel.deficit == 0)
+			{
+				channel.deficit = channel.options.weight;
+			}
+
+			selected.emplace_back(cursor_, std::move(channel.pending.front()));
+			channel.pending.pop_front();
+			--channel.deficit;
+			++channel.running;
+			++in_flight_;
+			--queued_;
+			skipped = 0;
+
+			if(channel.deficit == 0)
+			{
+				cursor_ = (cursor_ + 1) % channels_.size();
+			}
+		}
+
+		return selected;
+	}
+
+	template<typename Pool>
+	void FairScheduler<Pool>::dispatch(std::vector<std::pair<channel_id, detail::Task>> selected)
+	{
+		while(!selected.empty())
+		{
+			std::size_t sent = 0;
+			try
+			{
+				for(; sent < selected.size(); ++sent)
+				{
+					static_cast<void>(
+							pool_.enqueue(
+									[this, channel = selected[sent].first, work = std::move(selected[sent].second)]() mutable
+									{
+										work();
+										on_complete(channel);
+									}
+							)
+					);
+				}
+				return;
+			}
+			catch(...)
+			{
+				// the refused task and the rest of the selection are dropped, their slots go to the next selection
+				selected.erase(selected.begin(), selected.begin() + static_cast<std::ptrdiff_t>(sent));
+
+				std::vector<std::pair<channel_id, detail::Task>> next;
+				{
+					std::scoped_lock lock(mutex_);
+					next = drop_locked(selected);
+				}
+				selected = std::move(next);
+			}
+		}
+	}
+
+	template<typename Pool>
+	std::vector<std::pair<typename FairScheduler<Pool>::channel_id, detail::Task>> FairScheduler<Pool>::drop_locked(
+			const std::vector<std::pair<channel_id, detail::Task>>& dropped
+	)
+	{
+		for(const auto& [channel, task]: dropped)
+		{
+			auto& source = *channels_[channel];
+			--source.running;
+			++source.rejected;
+			--in_flight_;
+		}
+
+		auto selected = select_locked();
+		if(in_flight_ == 0 && queued_ == 0)
+		{
+			idle_cv_.notify_all();
+		}
+		return selected;
+	}
+
+	template<typename Pool>
+	void FairScheduler<Pool>::on_complete(channel_id channel)
+	{
+		std::vector<std::pair<channel_id, detail::Task>> selected;
+		{
+			std::scoped_lock lock(mutex_);
+			auto& source = *channels_[channel];
+			--source.running;
+			++source.completed;
+			--in_flight_;
+
+			selected = select_locked();
+
+			// notified under the lock, destructor may release the scheduler right after
+			if(in_flight_ == 0 && queued_ == 0)
+			{
+				idle_cv_.notify_all();
+			}
+		}
+		dispatch(std::move(selected));
+	}
+}
+
+#endif //THREAD_POOL_FAIR_SCHEDULER_HPP
@@ -0,0 +1,461 @@
+#ifndef THREAD_POOL_IO_EPOLL_REACTOR_HPP
+#define THREAD_POOL_IO_EPOLL_REACTOR_HPP
+
+#if defined(__linux__)
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include <atomic>
+#include <cerrno>
+#include <concepts>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+namespace thread_pool
+{
+	struct IoResult
+	{
+		std::size_t bytes = 0;
+		std::error_code error;
+	};
+
+	namespace detail
+	{
+		class IoCompletion
+		{
+		public:
+			virtual void complete(const IoResult& result) = 0;
+			virtual ~IoCompletion() = default;
+		};
+
+		template<typename F>
+		class IoCompletionImpl: public IoCompletion
+		{
+		public:
+			explicit IoCompletionImpl(F&& fun)
+			:
+				fun_(std::move(fun))
+			{}
+
+			void complete(const IoResult& result) final
+			{
+				fun_(result);
+			}
+
+		private:
+			F fun_;
+		};
+	}
+
+	/**
+	 * Readiness based I/O reactor completing operations on a thread pool.
+	 *
+	 * async_read/async_write try the operation right away and, if the descriptor is not ready,
+	 * register it in epoll. A single reactor thread performs the non-blocking syscall once the
+	 * descriptor becomes ready and enqueues the completion callback onto the pool, so pool workers
+	 * never wait for I/O. Operations on one descriptor complete in submission order per direction.
+	 *
+	 * Descriptors are switched to non-blocking mode when first used. The pool has to outlive the reactor;
+	 * operations still pending on destruction complete with std::errc::operation_canceled.
+	 */
+	template<typename Pool>
+	class EpollReactor
+	{
+	public:
+		explicit EpollReactor(Pool& pool);
+		~EpollReactor();
+
+		EpollReactor(const EpollReactor&) = delete;
+		EpollReactor& operator=(const EpollReactor&) = delete;
+
+		template<typename F>
+		requires std::invocable<std::decay_t<F>&, const IoResult&>
+		void async_read(int fd, void* buffer, std::size_t size, F&& on_complete);
+
+		template<typename F>
+		requires std::invocable<std::decay_t<F>&, const IoResult&>
+		void async_write(int fd, const void* buffer, std::size_t size, F&& on_complete);
+
+		/**
+		 * Completes all pending operations on fd with std::errc::operation_canceled.
+		 */
+		void cancel(int fd);
+
+	private:
+		struct Operation
+		{
+			void* buffer;
+			std::size_t size;
+			std::unique_ptr<detail::IoCompletion> completion;
+		};
+
+		struct Descriptor
+		{
+			std::deque<Operation> reads;
+			std::deque<Operation> writes;
+			std::uint32_t events = 0;
+		};
+
+		using completed_list = std::vector<std::pair<Operation, IoResult>>;
+
+		Pool& pool_;
+		int epoll_fd_;
+		int wake_fd_;
+
+		std::mutex mutex_;
+		std::unordered_map<int, Descriptor> descriptors_;
+
+		std::atomic<bool> stopped_ = false;
+		std::thread reactor_thread_;
+
+		template<typename F>
+		void submit(int fd, void* buffer, std::size_t size, bool write, F&& on_complete);
+
+		void reactor_loop();
+
+		static bool perform(int fd, Operation& operation, bool write, IoResult& result);
+		static void drain(int fd, std::deque<Operation>& operations, bool write, completed_list& completed);
+		std::error_code update_interest(int fd, Descriptor& descriptor);
+
+		void dispatch(completed_list& completed);
+		void cancel_all(Descriptor& descriptor, completed_list& completed);
+
+		static int check_fd(int fd);
+	};
+
+	template<typename Pool>
+	EpollReactor<Pool>::EpollReactor(Pool& pool)
+	:
+		pool_(pool),
+		epoll_fd_(check_fd(::epoll_create1(EPOLL_CLOEXEC))),
+		wake_fd_(::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))
+	{
+		if(wake_fd_ < 0)
+		{
+			const int error = errno;
+			::close(epoll_fd_);
+			throw std::system_error(error, std::system_category(), "eventfd");
+		}
+
+		epoll_event event{};
+		event.events = EPOLLIN;
+		event.data.fd = wake_fd_;
+		if(::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event) < 0)
+		{
+			const int error = errno;
+			::close(wake_fd_);
+			::close(epoll_fd_);
+			throw std::system_error(error, std::system_category(), "epoll_ctl");
+		}
+
+		reactor_thread_ = std::thread([this]() { reactor_loop(); });
+	}
+
+	template<typename Pool>
+	EpollReactor<Pool>::~EpollReactor()
+	{
+		stopped_.store(true);
+		const std::uint64_t wake = 1;
+		static_cast<void>(::write(wake_fd_, &wake, sizeof(wake)));
+		reactor_thread_.join();
+
+		completed_list completed;
+		{
+			std::scoped_lock lock(mutex_);
+			for(auto& [fd, descriptor]: descriptors_)
+			{
+				cancel_all(descriptor, completed);
+			}
+			descriptors_.clear();
+		}
+		dispatch(completed);
+
+		::close(wake_fd_);
+		::close(epoll_fd_);
+	}
+
+	template<typename Pool>
+	template<typename F>
+	requires std::invocable<std::decay_t<F>&, const IoResult&>
+	void EpollReactor<Pool>::async_read(int fd, void* buffer, std::size_t size, F&& on_complete)
+	{
+		submit(fd, buffer, size, false, std::forward<F>(on_complete));
+	}
+
+	template<typename Pool>
+	template<typename F>
+	requires std::invocable<std::decay_t<F>&, const IoResult&>
+	void EpollReactor<Pool>::async_write(int fd, const void* buffer, std::size_t size, F&& on_complete)
+	{
+		// the buffer is only read from, see perform()
+		submit(fd, const_cast<void*>(buffer), size, true, std::forward<F>(on_complete));
+	}
+
+	template<typename Pool>
+	void EpollReactor<Pool>::cancel(int fd)
+	{
+		completed_list completed;
+		{
+			std::scoped_lock lock(mutex_);
+			auto it = descriptors_.find(fd);
+			if(it == descriptors_.end())
+			{
+				return;
+			}
+
+			cancel_all(it->second, completed);
+			static_cast<void>(update_interest(fd, it->second));
+			descriptors_.erase(it);
+		}
+		dispatch(completed);
+	}
+
+	template<typename Pool>
+	template<typename F>
+	void EpollReactor<Pool>::submit(int fd, void* buffer, std::size_t size, bool write, F&& on_complete)
+	{
+		using completion_t = detail::IoCompletionImpl<std::decay_t<F>>;
+
+		Operation operation{
+			buffer,
+			size,
+			std::make_unique<completion_t>(std::decay_t<F>(std::forward<F>(on_complete)))
+		};
+
+		completed_list completed;
+		{
+			std::scoped_lock lock(mutex_);
+
+			auto [it, inserted] = descriptors_.try_emplace(fd);
+			auto& descriptor = it->second;
+			if(inserted)
+			{
+				const int flags = ::fcntl(fd, F_GETFL);
+				if(flags >= 0 && !(flags & O_NONBLOCK))
+				{
+					::fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+				}
+			}
+
+			auto& operations = write ? descriptor.writes : descriptor.reads;
+
+			IoResult result;
+			if(operations.empty() && perform(fd, operation, write, result))
+			{
+				completed.emplace_back(std::move(operation), result);
+			}
+			else
+			{
+				operations.push_back(std::move(operation));
+				if(auto error = update_interest(fd, descriptor))
+				{
+					completed.emplace_back(std::move(operations.back()), IoResult{0, error});
+					operations.pop_back();
+				}
+			}
+
+			if(descriptor.reads.empty() && descriptor.writes.empty())
+			{
+				static_cast<void>(update_interest(fd, descriptor));
+				descriptors_.erase(it);
+			}
+		}
+		dispatch(completed);
+	}
+
+	template<typename Pool>
+	void EpollReactor<Pool>::reactor_loop()
+	{
+		constexpr int max_events = 64;
+		epoll_event events[max_events];
+
+		while(!stopped_.load())
+		{
+			const int count = ::epoll_wait(epoll_fd_, events, max_events, -1);
+			if(count < 0)
+			{
+				if(errno == EINTR)
+				{
+					continue;
+				}
+				return;
+			}
+
+			completed_list completed;
+			{
+				std::scoped_lock lock(mutex_);
+				for(int i = 0; i < count; ++i)
+				{
+					const int fd = events[i].data.fd;
+					if(fd == wake_fd_)
+					{
+						std::uint64_t value;
+						static_cast<void>(::read(wake_fd_, &value, sizeof(value)));
+						continue;
+					}
+
+					auto it = descriptors_.find(fd);
+					if(it == descriptors_.end())
+					{
+						continue;
+					}
+
+					auto& descriptor = it->second;
+					const std::uint32_t ready = events[i].events;
+					if(ready & (EPOLLIN | EPOLLERR | EPOLLHUP))
+					{
+						drain(fd, descriptor.reads, false, completed);
+					}
+					if(ready & (EPOLLOUT | EPOLLERR | EPOLLHUP))
+					{
+						drain(fd, descriptor.writes, true, completed);
+					}
+
+					static_cast<void>(update_interest(fd, descriptor));
+					if(descriptor.reads.empty() && descriptor.writes.empty())
+					{
+						descriptors_.erase(it);
+					}
+				}
+			}
+			dispatch(completed);
+		}
+	}
+
+	template<typename Pool>
+	bool EpollReactor<Pool>::perform(int fd, Operation& operation, bool write, IoResult& result)
+	{
+		while(true)
+		{
+			const ssize_t transferred = write
+					? ::write(fd, operation.buffer, operation.size)
+					: ::read(fd, operation.buffer, operation.size);
+
+			if(transferred >= 0)
+			{
+				result = IoResult{static_cast<std::size_t>(transferred), {}};
+				return true;
+			}
+
+			const int error = errno;
+			if(error == EINTR)
+			{
+				continue;
+			}
+			if(error == EAGAIN || error == EWOULDBLOCK)
+			{
+				return false;
+			}
+
+			result = IoResult{0, std::error_code(error, std::system_category())};
+			return true;
+		}
+	}
+
+	template<typename Pool>
+	void EpollReactor<Pool>::drain(int fd, std::deque<Operation>& operations, bool write, completed_list& completed)
+	{
+		IoResult result;
+		while(!operations.empty() && perform(fd, operations.front(), write, result))
+		{
+			completed.emplace_back(std::move(operations.front()), result);
+			operations.pop_front();
+		}
+	}
+
+	template<typename Pool>
+	std::error_code EpollReactor<Pool>::update_interest(int fd, Descriptor& descriptor)
+	{
+		std::uint32_t wanted = 0;
+		if(!descriptor.reads.empty())
+		{
+			wanted |= EPOLLIN;
+		}
+		if(!descriptor.writes.empty())
+		{
+			wanted |= EPOLLOUT;
+		}
+
+		if(wanted == descriptor.events)
+		{
+			return {};
+		}
+
+		epoll_event event{};
+		event.events = wanted;
+		event.data.fd = fd;
+
+		int operation = EPOLL_CTL_MOD;
+		if(wanted == 0)
+		{
+			operation = EPOLL_CTL_DEL;
+		}
+		else if(descriptor.events == 0)
+		{
+			operation = EPOLL_CTL_ADD;
+		}
+
+		if(::epoll_ctl(epoll_fd_, operation, fd, &event) < 0)
+		{
+			return std::error_code(errno, std::system_category());
+		}
+
+		descriptor.events = wanted;
+		return {};
+	}
+
+	template<typename Pool>
+	void EpollReactor<Pool>::dispatch(completed_list& completed)
+	{
+		for(auto& [operation, result]: completed)
+		{
+			static_cast<void>(
+					pool_.enqueue(
+							[completion = std::move(operation.completion), result = result]() mutable
+							{
+								completion->complete(result);
+							}
+					)
+			);
+		}
+	}
+
+	template<typename Pool>
+	void EpollReactor<Pool>::cancel_all(Descriptor& descriptor, completed_list& completed)
+	{
+		const IoResult canceled{0, std::make_error_code(std::errc::operation_canceled)};
+		for(auto* operations: {&descriptor.reads, &descriptor.writes})
+		{
+			for(auto& operation: *operations)
+			{
+				completed.emplace_back(std::move(operation), canceled);
+			}
+			operations->clear();
+		}
+	}
+
+	template<typename Pool>
+	int EpollReactor<Pool>::check_fd(int fd)
+	{
+		if(fd < 0)
+		{
+			throw std::system_error(errno, std::system_category(), "epoll_create1");
+		}
+		return fd;
+	}
+}
+
+#endif
+
+#endif //THREAD_POOL_IO_EPOLL_REACTOR_HPP
@@ -0,0 +1,224 @@
+#ifndef THREAD_POOL_POLICY_HPP
+#define THREAD_POOL_POLICY_HPP
+
+#include "detail/_task.hpp"
+#include "detail/_bound_task.hpp"
+#include "queue/common.hpp"
+
+#include <thread>
+#include <future>
+#include <utility>
+
+
+namespace thread_pool
+{
+	/**
+	 * Idle worker parks on its queue right away.
+	 *
+	 * Wait strategies may also provide spin(poll), used by a sharded pool whose idle workers poll all shards
+	 * and then park on the pool itself: it returns true as soon as poll() found work.
+	 */
+	struct BlockingWait
+	{
+		template<typename Queue>
+		static QueueOpStatus wait_pop(Queue& queue, typename Queue::value_type& dest)
+		{
+			return queue.wait_pop(dest);
+		}
+
+		template<typename Poll>
+		static bool spin(Poll&&)
+		{
+			return false;
+		}
+	};
+
+	/**
+	 * Idle worker polls its queue Spins times before parking on it.
+	 */
+	template<std::size_t Spins>
+	struct SpinWait
+	{
+		template<typename Queue>
+		static QueueOpStatus wait_pop(Queue& queue, typename Queue::value_type& dest)
+		{
+			for(std::size_t i = 0; i < Spins; ++i)
+			{
+				auto state = queue.try_pop(dest);
+				if(state != QueueOpStatus::empty)
+				{
+					return state;
+				}
+				std::this_thread::yield();
+			}
+			return queue.wait_pop(dest);
+		}
+
+		template<typename Poll>
+		static bool spin(Poll&& poll)
+		{
+			for(std::size_t i = 0; i < Spins; ++i)
+			{
+				if(poll())
+				{
+					return true;
+				}
+				std::this_thread::yield();
+			}
+			return false;
+		}
+	};
+
+	/**
+	 * Result of every task is reported through std::future.
+	 *
+	 * Result policy creates the task object from the callable and its arguments and hands it over
+	 * to emplace_task(std::in_place_type<Task>, task constructor arguments...), which constructs it
+	 * directly in the pool task storage.
+	 */
+	struct FutureResult
+	{
+		template<typename R, typename Emplace, typename F, typename... Args>
+		static std::future<R> submit(Emplace&& emplace_task, F&& fun, Args&&... args)
+		{
+			using task_t = detail::PromiseTask<R, std::decay_t<F>, std::decay_t<Args>...>;
+
+			std::promise<R> promise;
+			auto task_future = promise.get_future();
+			emplace_task(std::in_place_type<task_t>, std::move(promise), std::forward<F>(fun), std::forward<Args>(args)...);
+
+			return task_future;
+		}
+	};
+
+	/**
+	 * Fire-and-forget tasks, nothing is returned to the caller.
+	 * Exception escaping a detached task terminates the program.
+	 */
+	struct DetachedResult
+	{
+		template<typename R, typename Emplace, typename F, typename... Args>
+		static void submit(Emplace&& emplace_task, F&& fun, Args&&... args)
+		{
+			using task_t = detail::DetachedTask<std::decay_t<F>, std::decay_t<Args>...>;
+
+			emplace_task(std::in_place_type<task_t>, std::forward<F>(fun), std::forward<Args>(args)...);
+		}
+	};
+
+	/**
+	 * Optional, user supplied name of a task passed to the metrics hook.
+	 * Label has to point to a string living as long as the metrics (e.g. a string literal).
+	 */
+	struct TaskLabel
+	{
+		explicit constexpr TaskLabel(const char* label = nullptr) noexcept
+		:
+			name(label)
+		{}
+
+		const char* name;
+	};
+
+	/**
+	 * Metrics hook which records nothing, tasks are not instrumented at all.
+	 *
+	 * Enabled hooks define task_token created on enqueue, stored along with the task and passed
+	 * to on_task_start/on_task_end together with the index of the worker running the task.
+	 * A hook may also define on_discard(token), called for a task the pool dropped before it ran
+	 * (e.g. refused by try_post or by a closed queue).
+	 */
+	struct NoMetrics
+	{
+		static constexpr bool enabled = false;
+	};
+
+	/**
+	 * Per-worker state which holds nothing.
+	 *
+	 * Worker state is constructed on the worker thread when it starts (from the worker index if it accepts one)
+	 * and destroyed when the worker stops, so its constructor and destructor act as worker start/stop hooks.
+	 * ThreadPool waits for all states to be constructed before its constructor returns.
+	 */
+	struct NoWorkerState {};
+
+	/**
+	 * No context is propagated from the submitting thread to the task.
+	 */
+	struct NoContext
+	{
+		static constexpr bool enabled = false;
+	};
+
+	/**
+	 * Propagates thread-local value of type T (e.g. a request id) from the thread calling enqueue
+	 * to the worker running the task. The value is captured on enqueue and installed for the duration of the task.
+	 */
+	template<typename T>
+	class ThreadLocalContext
+	{
+	public:
+		static constexpr bool enabled = true;
+
+		class scope
+		{
+		public:
+			explicit scope(T&& value)
+			:
+				previous_(std::exchange(value_, std::move(value)))
+			{}
+
+			~scope()
+			{
+				value_ = std::move(previous_);
+			}
+
+			scope(const scope&) = delete;
+			scope& operator=(const scope&) = delete;
+
+		private:
+			T previous_;
+		};
+
+		static T& current() noexcept
+		{
+			return value_;
+		}
+
+		static T capture()
+		{
+			return value_;
+		}
+
+	private:
+		static inline thread_local T value_{};
+	};
+
+	struct StdThreadFactory
+	{
+		using thread_type = std::thread;
+
+		template<typename F>
+		thread_type create(std::size_t, F&& fun)
+		{
+			return std::thread(std::forward<F>(fun));
+		}
+	};
+
+	/**
+	 * Policies reproducing the default ThreadPool behavior.
+	 * Custom configurations derive from it and override selected members.
+	 */
+	struct DefaultPolicy
+	{
+		using task_type = detail::Task;
+		using wait_strategy = BlockingWait;
+		using result_policy = FutureResult;
+		using metrics = NoMetrics;
+		using thread_factory = StdThreadFactory;
+		using worker_state = NoWorkerState;
+		using context = NoContext;
+	};
+}
+
+#endif //THREAD_POOL_POLICY_HPP
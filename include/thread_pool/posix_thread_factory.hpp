@@ -0,0 +1,309 @@
+#ifndef THREAD_POOL_POSIX_THREAD_FACTORY_HPP
+#define THREAD_POOL_POSIX_THREAD_FACTORY_HPP
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <exception>
+#include <future>
+#include <memory>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+
+namespace thread_pool
+{
+	struct ThreadAttributes
+	{
+		// reserved stack of every thread, 0 keeps the system default; raised to PTHREAD_STACK_MIN if needed
+		std::size_t stack_size = 0;
+		// "{}" is replaced with the worker index, Linux truncates names to 15 characters
+		std::string name_pattern;
+		// anything but SCHED_OTHER uses explicit scheduling instead of inheriting the creator's
+		int sched_policy = SCHED_OTHER;
+		int sched_priority = 0;
+		// per-thread nice value, Linux only
+		std::optional<int> nice;
+	};
+
+	/**
+	 * Joinable pthread handle with the std::thread interface used by ThreadPool.
+	 */
+	class PosixThread
+	{
+	public:
+		PosixThread() noexcept = default;
+
+		explicit PosixThread(pthread_t handle) noexcept
+		:
+			handle_(handle),
+			joinable_(true)
+		{}
+
+		PosixThread(PosixThread&& other) noexcept
+		:
+			handle_(other.handle_),
+			joinable_(std::exchange(other.joinable_, false))
+		{}
+
+		PosixThread& operator=(PosixThread&& other) noexcept
+		{
+			if(joinable_)
+			{
+				std::terminate();
+			}
+			handle_ = other.handle_;
+			joinable_ = std::exchange(other.joinable_, false);
+			return *this;
+		}
+
+		~PosixThread()
+		{
+			if(joinable_)
+			{
+				std::terminate();
+			}
+		}
+
+		[[nodiscard]] bool joinable() const noexcept
+		{
+			return joinable_;
+		}
+
+		void join()
+		{
+			if(!joinable_)
+			{
+				throw std::system_error(std::make_error_code(std::errc::invalid_argument), "Thread is not joinable");
+			}
+
+			const int error = pthread_join(handle_, nullptr);
+			if(error != 0)
+			{
+				throw std::system_error(error, std::system_category(), "pthread_join failed");
+			}
+			joinable_ = false;
+		}
+
+		[[nodiscard]] pthread_t native_handle() const noexcept
+		{
+			return handle_;
+		}
+
+	private:
+		pthread_t handle_{};
+		bool joinable_ = false;
+	};
+
+	/**
+	 * Thread factory creating workers through pthread with the given ThreadAttributes.
+	 *
+	 * Stack size and scheduling are set on the pthread attributes, name and nice value by the new
+	 * thread itself before it runs the worker. create() waits for that setup and throws
+	 * std::system_error (like std::thread does) if any step fails, e.g. EPERM for SCHED_FIFO
+	 * without the needed privileges.
+	 */
+	class PosixThreadFactory
+	{
+	public:
+		using thread_type = PosixThread;
+
+		PosixThreadFactory() = default;
+
+		explicit PosixThreadFactory(ThreadAttributes attributes)
+		:
+			attributes_(std::move(attributes))
+		{}
+
+		template<typename F>
+		thread_type create(std::size_t index, F&& fun);
+
+		[[nodiscard]] const ThreadAttributes& attributes() const noexcept
+		{
+			return attributes_;
+		}
+
+		/**
+		 * Name of the thread with index, name_pattern with "{}" replaced.
+		 */
+		[[nodiscard]] std::string thread_name(std::size_t index) const;
+
+	private:
+		ThreadAttributes attributes_;
+
+		class Attr
+		{
+		public:
+			Attr()
+			{
+				check(pthread_attr_init(&attr_), "pthread_attr_init failed");
+			}
+
+			~Attr()
+			{
+				pthread_attr_destroy(&attr_);
+			}
+
+			Attr(const Attr&) = delete;
+			Attr& operator=(const Attr&) = delete;
+
+			pthread_attr_t* get() noexcept
+			{
+				return &attr_;
+			}
+
+		private:
+			pthread_attr_t attr_;
+		};
+
+		template<typename F>
+		struct Start
+		{
+			F fun;
+			std::string name;
+			std::optional<int> nice;
+			std::promise<void> setup;
+		};
+
+		static void check(int error, const char* what)
+		{
+			if(error != 0)
+			{
+				throw std::system_error(error, std::system_category(), what);
+			}
+		}
+
+		void configure(Attr& attr) const;
+
+		// applied by the new thread to itself
+		static void setup_current(const std::string& name, const std::optional<int>& nice);
+
+		template<typename F>
+		static void* run(void* arg) noexcept;
+	};
+
+	template<typename F>
+	PosixThreadFactory::thread_type PosixThreadFactory::create(std::size_t index, F&& fun)
+	{
+		using start_type = Start<std::decay_t<F>>;
+
+		Attr attr;
+		configure(attr);
+
+		auto start = std::make_unique<start_type>(start_type{std::forward<F>(fun), thread_name(index), attributes_.nice, {}});
+		auto setup = start->setup.get_future();
+
+		pthread_t handle;
+		check(pthread_create(&handle, attr.get(), &PosixThreadFactory::run<std::decay_t<F>>, start.get()), "pthread_create failed");
+		// owned by the thread from now on
+		static_cast<void>(start.release());
+
+		PosixThread thread(handle);
+		try
+		{
+			setup.get();
+		}
+		catch(...)
+		{
+			// the thread exits without running fun
+			thread.join();
+			throw;
+		}
+		return thread;
+	}
+
+	inline std::string PosixThreadFactory::thread_name(std::size_t index) const
+	{
+		std::string name = attributes_.name_pattern;
+		if(const auto placeholder = name.find("{}"); placeholder != std::string::npos)
+		{
+			name.replace(placeholder, 2, std::to_string(index));
+		}
+		return name;
+	}
+
+	inline void PosixThreadFactory::configure(Attr& attr) const
+	{
+		if(attributes_.stack_size != 0)
+		{
+			const std::size_t minimum = static_cast<std::size_t>(PTHREAD_STACK_MIN);
+			check(pthread_attr_setstacksize(attr.get(), std::max(attributes_.stack_size, minimum)), "pthread_attr_setstacksize failed");
+		}
+
+		if(attributes_.sched_policy != SCHED_OTHER)
+		{
+			sched_param param{};
+			param.sched_priority = attributes_.sched_priority;
+
+			check(pthread_attr_setinheritsched(attr.get(), PTHREAD_EXPLICIT_SCHED), "pthread_attr_setinheritsched failed");
+			check(pthread_attr_setschedpolicy(attr.get(), attributes_.sched_policy), "pthread_attr_setschedpolicy failed");
+			check(pthread_attr_setschedparam(attr.get(), &param), "pthread_attr_setschedparam failed");
+		}
+	}
+
+	inline void PosixThreadFactory::setup_current(const std::string& name, const std::optional<int>& nice)
+	{
+		if(!name.empty())
+		{
+#if defined(__linux__)
+			// longer names are rejected with ERANGE
+			check(pthread_setname_np(pthread_self(), name.substr(0, 15).c_str()), "pthread_setname_np failed");
+#elif defined(__APPLE__)
+			check(pthread_setname_np(name.c_str()), "pthread_setname_np failed");
+#endif
+		}
+
+		if(nice)
+		{
+#if defined(__linux__)
+			// on Linux the nice value belongs to the thread, not the whole process
+			const auto tid = static_cast<id_t>(syscall(SYS_gettid));
+			if(setpriority(PRIO_PROCESS, tid, *nice) != 0)
+			{
+				check(errno, "setpriority failed");
+			}
+#else
+			check(ENOTSUP, "Per-thread nice value is not supported");
+#endif
+		}
+	}
+
+	template<typename F>
+	void* PosixThreadFactory::run(void* arg) noexcept
+	{
+		std::unique_ptr<Start<F>> start(static_cast<Start<F>*>(arg));
+		try
+		{
+			setup_current(start->name, start->nice);
+		}
+		catch(...)
+		{
+			start->setup.set_exception(std::current_exception());
+			return nullptr;
+		}
+		start->setup.set_value();
+
+		// an escaping exception terminates, as with std::thread
+		start->fun();
+		return nullptr;
+	}
+}
+
+#endif
+
+#endif //THREAD_POOL_POSIX_THREAD_FACTORY_HPP
@@ -1,6 +1,7 @@
 #ifndef THREAD_POOL_COMMON_HPP
 #define THREAD_POOL_COMMON_HPP
 
+#include <cstddef>
 #include <exception>
 
 
@@ -11,7 +12,18 @@ namespace thread_pool
 		success = 0,
 		closed,
 		empty,
-		full
+		full,
+		timeout
+	};
+
+	/**
+	 * Lock-free, approximate view of a queue, see stats() of the queues.
+	 */
+	struct QueueStats
+	{
+		std::size_t size;
+		std::size_t high_water_mark;
+		bool closed;
 	};
 
 	class QueueException: public std::exception {};
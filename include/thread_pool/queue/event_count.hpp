@@ -0,0 +1,323 @@
+#ifndef THREAD_POOL_EVENT_COUNT_HPP
+#define THREAD_POOL_EVENT_COUNT_HPP
+
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+
+namespace thread_pool
+{
+	/**
+	 * Eventcount: lets a thread wait for a condition guarded by some other synchronization
+	 * (a mutex or plain atomics) without sharing a lock with the notifier.
+	 *
+	 * Waiter: key = prepare_wait(); check the condition; then either cancel_wait() or commit_wait(key).
+	 * Notifier: make the condition true; then notify_one() / notify_all().
+	 *
+	 * Waiter count and epoch share one atomic word, so notify is a single load when nobody waits.
+	 * On Linux waiters sleep on a futex on the epoch half, elsewhere on an internal condition variable.
+	 * notify_all() wakes every sleeper at once; wakeups are not handed from waiter to waiter, because
+	 * neither the futex (ordered by priority) nor the condition variable wakes in arrival order and
+	 * a handed over wakeup could reach a waiter of a newer epoch instead of one of the old.
+	 */
+	class EventCount
+	{
+	public:
+		class Key
+		{
+		private:
+			friend class EventCount;
+
+			explicit Key(std::uint32_t epoch)
+			:
+				epoch_(epoch)
+			{}
+
+			std::uint32_t epoch_;
+		};
+
+		EventCount() = default;
+
+		EventCount(const EventCount&) = delete;
+		EventCount& operator=(const EventCount&) = delete;
+
+		[[nodiscard]] Key prepare_wait() noexcept;
+		void cancel_wait() noexcept;
+		void commit_wait(Key key) noexcept;
+
+		/**
+		 * Returns false when deadline passed without a notification.
+		 */
+		template<typename Clock, typename Duration>
+		bool commit_wait_until(Key key, const std::chrono::time_point<Clock, Duration>& deadline) noexcept;
+
+		void notify_one() noexcept;
+		void notify_all() noexcept;
+
+	private:
+		static constexpr std::uint64_t waiter_inc = 1;
+		static constexpr std::uint64_t waiter_mask = 0xffffffff;
+		static constexpr int epoch_shift = 32;
+		static constexpr std::uint64_t epoch_inc = std::uint64_t{1} << epoch_shift;
+
+		std::atomic<std::uint64_t> state_ = 0;
+
+#if !defined(__linux__)
+		std::mutex sleep_mutex_;
+		std::condition_variable sleep_cv_;
+#endif
+
+		std::uint32_t epoch() const noexcept;
+		void finish_wait() noexcept;
+
+		// sleeps while the epoch equals expected, spurious returns allowed
+		bool sleep(std::uint32_t expected, const std::chrono::steady_clock::time_point* deadline) noexcept;
+		void wake_one() noexcept;
+		void wake_all() noexcept;
+	};
+
+	/**
+	 * Drop-in replacement for std::condition_variable (with std::mutex) built on EventCount.
+	 *
+	 * Notifications do not touch any mutex and cost a single atomic load without waiters.
+	 */
+	class EventCountCondition
+	{
+	public:
+		void wait(std::unique_lock<std::mutex>& lock);
+
+		template<typename Predicate>
+		void wait(std::unique_lock<std::mutex>& lock, Predicate predicate);
+
+		template<typename Clock, typename Duration>
+		std::cv_status wait_until(std::unique_lock<std::mutex>& lock, const std::chrono::time_point<Clock, Duration>& deadline);
+
+		template<typename Clock, typename Duration, typename Predicate>
+		bool wait_until(
+				std::unique_lock<std::mutex>& lock,
+				const std::chrono::time_point<Clock, Duration>& deadline,
+				Predicate predicate
+		);
+
+		void notify_one() noexcept;
+		void notify_all() noexcept;
+
+	private:
+		EventCount event_count_;
+	};
+
+	inline EventCount::Key EventCount::prepare_wait() noexcept
+	{
+		const std::uint64_t previous = state_.fetch_add(waiter_inc);
+		return Key(static_cast<std::uint32_t>(previous >> epoch_shift));
+	}
+
+	inline void EventCount::cancel_wait() noexcept
+	{
+		finish_wait();
+	}
+
+	inline void EventCount::commit_wait(Key key) noexcept
+	{
+		while(epoch() == key.epoch_)
+		{
+			sleep(key.epoch_, nullptr);
+		}
+		finish_wait();
+	}
+
+	template<typename Clock, typename Duration>
+	bool EventCount::commit_wait_until(Key key, const std::chrono::time_point<Clock, Duration>& deadline) noexcept
+	{
+		const auto steady_deadline = std::chrono::steady_clock::now()
+				+ std::chrono::duration_cast<std::chrono::steady_clock::duration>(deadline - Clock::now());
+
+		bool notified = true;
+		while(epoch() == key.epoch_)
+		{
+			if(!sleep(key.epoch_, &steady_deadline) || Clock::now() >= deadline)
+			{
+				notified = epoch() != key.epoch_;
+				break;
+			}
+		}
+		finish_wait();
+		return notified;
+	}
+
+	inline void EventCount::notify_one() noexcept
+	{
+		if((state_.load() & waiter_mask) == 0)
+		{
+			return;
+		}
+
+		state_.fetch_add(epoch_inc);
+		wake_one();
+	}
+
+	inline void EventCount::notify_all() noexcept
+	{
+		const std::uint64_t previous = state_.fetch_add(epoch_inc);
+		if((previous & waiter_mask) == 0)
+		{
+			return;
+		}
+
+		wake_all();
+	}
+
+	inline std::uint32_t EventCount::epoch() const noexcept
+	{
+		return static_cast<std::uint32_t>(state_.load(std::memory_order_acquire) >> epoch_shift);
+	}
+
+	inline void EventCount::finish_wait() noexcept
+	{
+		state_.fetch_sub(waiter_inc);
+	}
+
+#if defined(__linux__)
+	inline bool EventCount::sleep(std::uint32_t expected, const std::chrono::steady_clock::time_point* deadline) noexcept
+	{
+		static_assert(sizeof(std::atomic<std::uint64_t>) == sizeof(std::uint64_t));
+
+		// the futex word is the epoch half of state_
+		auto* word = reinterpret_cast<std::uint32_t*>(&state_) + (std::endian::native == std::endian::little ? 1 : 0);
+
+		timespec timeout{};
+		if(deadline != nullptr)
+		{
+			const auto since_epoch = deadline->time_since_epoch();
+			const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(since_epoch);
+			timeout.tv_sec = static_cast<std::time_t>(seconds.count());
+			timeout.tv_nsec = static_cast<long>(std::chrono::duration_cast<std::chrono::nanoseconds>(since_epoch - seconds).count());
+		}
+
+		// steady_clock is CLOCK_MONOTONIC, the default clock of FUTEX_WAIT_BITSET
+		const long result = syscall(
+				SYS_futex,
+				word,
+				FUTEX_WAIT_BITSET | FUTEX_PRIVATE_FLAG,
+				expected,
+				deadline != nullptr ? &timeout : nullptr,
+				nullptr,
+				FUTEX_BITSET_MATCH_ANY
+		);
+		return result == 0 || errno != ETIMEDOUT;
+	}
+
+	inline void EventCount::wake_one() noexcept
+	{
+		auto* word = reinterpret_cast<std::uint32_t*>(&state_) + (std::endian::native == std::endian::little ? 1 : 0);
+		syscall(SYS_futex, word, FUTEX_WAKE | FUTEX_PRIVATE_FLAG, 1, nullptr, nullptr, 0);
+	}
+
+	inline void EventCount::wake_all() noexcept
+	{
+		auto* word = reinterpret_cast<std::uint32_t*>(&state_) + (std::endian::native == std::endian::little ? 1 : 0);
+		syscall(SYS_futex, word, FUTEX_WAKE | FUTEX_PRIVATE_FLAG, INT_MAX, nullptr, nullptr, 0);
+	}
+#else
+	inline bool EventCount::sleep(std::uint32_t expected, const std::chrono::steady_clock::time_point* deadline) noexcept
+	{
+		std::unique_lock lock(sleep_mutex_);
+		if(deadline == nullptr)
+		{
+			sleep_cv_.wait(lock, [&](){ return epoch() != expected; });
+			return true;
+		}
+		return sleep_cv_.wait_until(lock, *deadline, [&](){ return epoch() != expected; });
+	}
+
+	inline void EventCount::wake_one() noexcept
+	{
+		{
+			std::scoped_lock lock(sleep_mutex_);
+		}
+		sleep_cv_.notify_one();
+	}
+
+	inline void EventCount::wake_all() noexcept
+	{
+		{
+			std::scoped_lock lock(sleep_mutex_);
+		}
+		sleep_cv_.notify_all();
+	}
+#endif
+
+	inline void EventCountCondition::wait(std::unique_lock<std::mutex>& lock)
+	{
+		// registered before the lock is released, so a notifier which runs after that sees the waiter
+		const EventCount::Key key = event_count_.prepare_wait();
+		lock.unlock();
+		event_count_.commit_wait(key);
+		lock.lock();
+	}
+
+	template<typename Predicate>
+	void EventCountCondition::wait(std::unique_lock<std::mutex>& lock, Predicate predicate)
+	{
+		while(!predicate())
+		{
+			wait(lock);
+		}
+	}
+
+	template<typename Clock, typename Duration>
+	std::cv_status EventCountCondition::wait_until(
+			std::unique_lock<std::mutex>& lock,
+			const std::chrono::time_point<Clock, Duration>& deadline
+	)
+	{
+		const EventCount::Key key = event_count_.prepare_wait();
+		lock.unlock();
+		const bool notified = event_count_.commit_wait_until(key, deadline);
+		lock.lock();
+
+		return notified ? std::cv_status::no_timeout : std::cv_status::timeout;
+	}
+
+	template<typename Clock, typename Duration, typename Predicate>
+	bool EventCountCondition::wait_until(
+			std::unique_lock<std::mutex>& lock,
+			const std::chrono::time_point<Clock, Duration>& deadline,
+			Predicate predicate
+	)
+	{
+		while(!predicate())
+		{
+			if(wait_until(lock, deadline) == std::cv_status::timeout)
+			{
+				return predicate();
+			}
+		}
+		return true;
+	}
+
+	inline void EventCountCondition::notify_one() noexcept
+	{
+		event_count_.notify_one();
+	}
+
+	inline void EventCountCondition::notify_all() noexcept
+	{
+		event_count_.notify_all();
+	}
+}
+
+#endif //THREAD_POOL_EVENT_COUNT_HPP
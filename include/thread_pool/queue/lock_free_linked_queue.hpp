@@ -0,0 +1,689 @@
+#ifndef THREAD_POOL_LOCK_FREE_LINKED_QUEUE_HPP
+#define THREAD_POOL_LOCK_FREE_LINKED_QUEUE_HPP
+
+#include "common.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+
+namespace thread_pool
+{
+	/**
+	 * Unbounded lock-free MPMC queue built from a linked list of fixed-size blocks.
+	 *
+	 * Producers and consumers claim positions with a CAS on the tail/head index and then publish
+	 * or consume the slot through a per-slot state word. A block is released by whichever thread
+	 * finishes with its last slot, so no epoch or hazard pointer bookkeeping is needed. Released
+	 * blocks are parked in a few spare slots and reused by the next producer crossing a block
+	 * boundary instead of going back to the allocator.
+	 *
+	 * Push and pop are lock-free. Only consumers which found the queue empty for a while park on
+	 * a condition variable; producers touch its mutex only when a consumer is parked.
+	 *
+	 * value_type has to be nothrow move constructible and assignable.
+	 */
+	template<typename T>
+	class LockFreeLinkedQueue
+	{
+	public:
+		using value_type = T;
+
+		static_assert(std::is_nothrow_move_constructible_v<T> && std::is_nothrow_move_assignable_v<T>);
+
+		static constexpr std::size_t block_capacity = 63;
+		static constexpr std::size_t spare_blocks = 4;
+		static constexpr std::size_t spin_limit = 64;
+
+		LockFreeLinkedQueue() = default;
+		~LockFreeLinkedQueue();
+
+		LockFreeLinkedQueue(const LockFreeLinkedQueue&) = delete;
+		LockFreeLinkedQueue& operator=(const LockFreeLinkedQueue&) = delete;
+
+		void push(const value_type& elem);
+		void push(value_type&& elem);
+
+		QueueOpStatus try_push(const value_type& elem);
+		QueueOpStatus try_push(value_type&& elem);
+
+		[[nodiscard]] QueueOpStatus wait_push(const value_type& elem);
+		[[nodiscard]] QueueOpStatus wait_push(value_type&& elem);
+
+		template<typename Rep, typename Period>
+		[[nodiscard]] QueueOpStatus wait_push_for(const value_type& elem, const std::chrono::duration<Rep, Period>& timeout);
+		template<typename Rep, typename Period>
+		[[nodiscard]] QueueOpStatus wait_push_for(value_type&& elem, const std::chrono::duration<Rep, Period>& timeout);
+
+		template<typename Clock, typename Duration>
+		[[nodiscard]] QueueOpStatus wait_push_until(
+				const value_type& elem,
+				const std::chrono::time_point<Clock, Duration>& deadline
+		);
+		template<typename Clock, typename Duration>
+		[[nodiscard]] QueueOpStatus wait_push_until(
+				value_type&& elem,
+				const std::chrono::time_point<Clock, Duration>& deadline
+		);
+
+		[[nodiscard]] value_type value_pop();
+
+		[[nodiscard]] QueueOpStatus try_pop(value_type& dest);
+
+		[[nodiscard]] QueueOpStatus wait_pop(value_type& dest);
+
+		template<typename Rep, typename Period>
+		[[nodiscard]] QueueOpStatus wait_pop_for(value_type& dest, const std::chrono::duration<Rep, Period>& timeout);
+
+		template<typename Clock, typename Duration>
+		[[nodiscard]] QueueOpStatus wait_pop_until(
+				value_type& dest,
+				const std::chrono::time_point<Clock, Duration>& deadline
+		);
+
+		void close() noexcept;
+		[[nodiscard]] bool closed() const noexcept;
+
+		[[nodiscard]] bool empty() const noexcept;
+		[[nodiscard]] bool full() const noexcept;
+
+		/**
+		 * Approximate while other threads push or pop.
+		 */
+		[[nodiscard]] std::size_t size() const noexcept;
+		[[nodiscard]] std::size_t allocated_blocks() const noexcept;
+
+	private:
+		// index layout: position << shift | flag, one position per lap is a block boundary and holds no slot
+		static constexpr std::size_t shift = 1;
+		static constexpr std::size_t lap = block_capacity + 1;
+		// head flag: the head block has a successor, no need to look at the tail
+		static constexpr std::uint64_t has_next = 1;
+		// tail flag: the queue is closed
+		static constexpr std::uint64_t closed_bit = 1;
+
+		static constexpr std::uint32_t slot_written = 1;
+		static constexpr std::uint32_t slot_read = 2;
+		static constexpr std::uint32_t slot_destroy = 4;
+
+		struct Slot
+		{
+			alignas(T) std::byte storage[sizeof(T)];
+			std::atomic<std::uint32_t> state = 0;
+
+			T* value() noexcept
+			{
+				return std::launder(reinterpret_cast<T*>(storage));
+			}
+		};
+
+		struct Block
+		{
+			std::atomic<Block*> next = nullptr;
+			std::array<Slot, block_capacity> slots;
+		};
+
+		struct alignas(64) Position
+		{
+			std::atomic<std::uint64_t> index = 0;
+			std::atomic<Block*> block = nullptr;
+		};
+
+		Position head_;
+		Position tail_;
+
+		std::array<std::atomic<Block*>, spare_blocks> spare_ = {};
+		std::atomic<std::size_t> allocated_blocks_ = 0;
+
+		alignas(64) std::atomic<std::size_t> sleepers_ = 0;
+		std::mutex sleep_mutex_;
+		std::condition_variable sleep_cv_;
+
+		Block* acquire_block();
+		void release_block(Block* block) noexcept;
+		void destroy_block(Block* block, std::size_t start) noexcept;
+
+		static Block* wait_next(Block* block) noexcept;
+		static void wait_written(Slot& slot) noexcept;
+
+		QueueOpStatus push_impl(value_type&& elem);
+
+		template<typename Sink>
+		QueueOpStatus pop_impl(Sink&& sink);
+
+		template<typename Sink, typename Clock, typename Duration>
+		QueueOpStatus wait_pop_impl(Sink&& sink, const std::optional<std::chrono::time_point<Clock, Duration>>& deadline);
+
+		void wake_sleepers() noexcept;
+	};
+
+	template<typename T>
+	LockFreeLinkedQueue<T>::~LockFreeLinkedQueue()
+	{
+		std::uint64_t head = head_.index.load(std::memory_order_relaxed) & ~has_next;
+		const std::uint64_t tail = tail_.index.load(std::memory_order_relaxed) & ~closed_bit;
+		Block* block = head_.block.load(std::memory_order_relaxed);
+
+		while(head >> shift != tail >> shift)
+		{
+			const std::size_t offset = (head >> shift) % lap;
+			if(offset < block_capacity)
+			{
+				std::destroy_at(block->slots[offset].value());
+			}
+			else
+			{
+				Block* next = block->next.load(std::memory_order_relaxed);
+				delete block;
+				block = next;
+			}
+			head += 1 << shift;
+		}
+		delete block;
+
+		for(auto& spare: spare_)
+		{
+			delete spare.load(std::memory_order_relaxed);
+		}
+	}
+
+	template<typename T>
+	void LockFreeLinkedQueue<T>::push(const value_type& elem)
+	{
+		if(wait_push(elem) == QueueOpStatus::closed)
+		{
+			throw QueueClosedException();
+		}
+	}
+
+	template<typename T>
+	void LockFreeLinkedQueue<T>::push(value_type&& elem)
+	{
+		if(wait_push(std::move(elem)) == QueueOpStatus::closed)
+		{
+			throw QueueClosedException();
+		}
+	}
+
+	template<typename T>
+	QueueOpStatus LockFreeLinkedQueue<T>::try_push(const value_type& elem)
+	{
+		return wait_push(elem);
+	}
+
+	template<typename T>
+	QueueOpStatus LockFreeLinkedQueue<T>::try_push(value_type&& elem)
+	{
+		return wait_push(std::move(elem));
+	}
+
+	template<typename T>
+	QueueOpStatus LockFreeLinkedQueue<T>::wait_push(const value_type& elem)
+	{
+		// copy before claiming a slot, a claimed slot has to be filled
+		value_type copy(elem);
+		return push_impl(std::move(copy));
+	}
+
+	template<typename T>
+	QueueOpStatus LockFreeLinkedQueue<T>::wait_push(value_type&& elem)
+	{
+		return push_impl(std::move(elem));
+	}
+
+	template<typename T>
+	template<typename Rep, typename Period>
+	QueueOpStatus LockFreeLinkedQueue<T>::wait_push_for(const value_type& elem, const std::chrono::duration<Rep, Period>&)
+	{
+		return wait_push(elem);
+	}
+
+	template<typename T>
+	template<typename Rep, typename Period>
+	QueueOpStatus LockFreeLinkedQueue<T>::wait_push_for(value_type&& elem, const std::chrono::duration<Rep, Period>&)
+	{
+		return wait_push(std::move(elem));
+	}
+
+	template<typename T>
+	template<typename Clock, typename Duration>
+	QueueOpStatus LockFreeLinkedQueue<T>::wait_push_until(
+			const value_type& elem,
+			const std::chrono::time_point<Clock, Duration>&
+	)
+	{
+		return wait_push(elem);
+	}
+
+	template<typename T>
+	template<typename Clock, typename Duration>
+	QueueOpStatus LockFreeLinkedQueue<T>::wait_push_until(
+			value_type&& elem,
+			const std::chrono::time_point<Clock, Duration>&
+	)
+	{
+		return wait_push(std::move(elem));
+	}
+
+	template<typename T>
+	typename LockFreeLinkedQueue<T>::value_type LockFreeLinkedQueue<T>::value_pop()
+	{
+		std::optional<value_type> elem;
+		const QueueOpStatus status = wait_pop_impl(
+				[&](value_type&& value){ elem.emplace(std::move(value)); },
+				std::optional<std::chrono::steady_clock::time_point>()
+		);
+		if(status == QueueOpStatus::closed)
+		{
+			throw QueueClosedException();
+		}
+
+		return std::move(*elem);
+	}
+
+	template<typename T>
+	QueueOpStatus LockFreeLinkedQueue<T>::try_pop(value_type& dest)
+	{
+		return pop_impl([&](value_type&& value){ dest = std::move(value); });
+	}
+
+	template<typename T>
+	QueueOpStatus LockFreeLinkedQueue<T>::wait_pop(value_type& dest)
+	{
+		return wait_pop_impl(
+				[&](value_type&& value){ dest = std::move(value); },
+				std::optional<std::chrono::steady_clock::time_point>()
+		);
+	}
+
+	template<typename T>
+	template<typename Rep, typename Period>
+	QueueOpStatus LockFreeLinkedQueue<T>::wait_pop_for(value_type& dest, const std::chrono::duration<Rep, Period>& timeout)
+	{
+		return wait_pop_until(dest, std::chrono::steady_clock::now() + timeout);
+	}
+
+	template<typename T>
+	template<typename Clock, typename Duration>
+	QueueOpStatus LockFreeLinkedQueue<T>::wait_pop_until(
+			value_type& dest,
+			const std::chrono::time_point<Clock, Duration>& deadline
+	)
+	{
+		return wait_pop_impl(
+				[&](value_type&& value){ dest = std::move(value); },
+				std::optional<std::chrono::time_point<Clock, Duration>>(deadline)
+		);
+	}
+
+	template<typename T>
+	void LockFreeLinkedQueue<T>::close() noexcept
+	{
+		tail_.index.fetch_or(closed_bit);
+		{
+			std::scoped_lock lock(sleep_mutex_);
+		}
+		sleep_cv_.notify_all();
+	}
+
+	template<typename T>
+	bool LockFreeLinkedQueue<T>::closed() const noexcept
+	{
+		return (tail_.index.load() & closed_bit) != 0;
+	}
+
+	template<typename T>
+	bool LockFreeLinkedQueue<T>::empty() const noexcept
+	{
+		return size() == 0;
+	}
+
+	template<typename T>
+	bool LockFreeLinkedQueue<T>::full() const noexcept
+	{
+		return false;
+	}
+
+	template<typename T>
+	std::size_t LockFreeLinkedQueue<T>::size() const noexcept
+	{
+		std::uint64_t head = head_.index.load() >> shift;
+		std::uint64_t tail = tail_.index.load() >> shift;
+
+		// boundary positions are transient, count them as the start of the next block
+		head += head % lap == block_capacity;
+		tail += tail % lap == block_capacity;
+		if(tail <= head)
+		{
+			return 0;
+		}
+		return static_cast<std::size_t>(tail - head - (tail / lap - head / lap));
+	}
+
+	template<typename T>
+	std::size_t LockFreeLinkedQueue<T>::allocated_blocks() const noexcept
+	{
+		return allocated_blocks_.load(std::memory_order_relaxed);
+	}
+
+	template<typename T>
+	typename LockFreeLinkedQueue<T>::Block* LockFreeLinkedQueue<T>::acquire_block()
+	{
+		// exchange hands out exclusive ownership, so the spare slots have no ABA problem
+		for(auto& spare: spare_)
+		{
+			if(spare.load(std::memory_order_relaxed) != nullptr)
+			{
+				if(Block* block = spare.exchange(nullptr, std::memory_order_acquire))
+				{
+					return block;
+				}
+			}
+		}
+
+		Block* block = new Block();
+		allocated_blocks_.fetch_add(1, std::memory_order_relaxed);
+		return block;
+	}
+
+	template<typename T>
+	void LockFreeLinkedQueue<T>::release_block(Block* block) noexcept
+	{
+		block->next.store(nullptr, std::memory_order_relaxed);
+		for(auto& slot: block->slots)
+		{
+			slot.state.store(0, std::memory_order_relaxed);
+		}
+
+		for(auto& spare: spare_)
+		{
+			Block* expected = nullptr;
+			if(spare.compare_exchange_strong(expected, block, std::memory_order_release, std::memory_order_relaxed))
+			{
+				return;
+			}
+		}
+
+		delete block;
+		allocated_blocks_.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	template<typename T>
+	void LockFreeLinkedQueue<T>::destroy_block(Block* block, std::size_t start) noexcept
+	{
+		// the reader of the last slot always starts destruction, so it does not need a flag
+		for(std::size_t i = start; i + 1 < block_capacity; ++i)
+		{
+			Slot& slot = block->slots[i];
+
+			// a reader still busy with the slot continues the destruction when done
+			if((slot.state.load(std::memory_order_acquire) & slot_read) == 0
+					&& (slot.state.fetch_or(slot_destroy, std::memory_order_acq_rel) & slot_read) == 0)
+			{
+				return;
+			}
+		}
+
+		release_block(block);
+	}
+
+	template<typename T>
+	typename LockFreeLinkedQueue<T>::Block* LockFreeLinkedQueue<T>::wait_next(Block* block) noexcept
+	{
+		while(true)
+		{
+			if(Block* next = block->next.load(std::memory_order_acquire))
+			{
+				return next;
+			}
+			std::this_thread::yield();
+		}
+	}
+
+	template<typename T>
+	void LockFreeLinkedQueue<T>::wait_written(Slot& slot) noexcept
+	{
+		while((slot.state.load(std::memory_order_acquire) & slot_written) == 0)
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	template<typename T>
+	QueueOpStatus LockFreeLinkedQueue<T>::push_impl(value_type&& elem)
+	{
+		std::uint64_t tail = tail_.index.load(std::memory_order_acquire);
+		Block* block = tail_.block.load(std::memory_order_acquire);
+		Block* next_block = nullptr;
+
+		while(true)
+		{
+			if((tail & closed_bit) != 0)
+			{
+				if(next_block != nullptr)
+				{
+					release_block(next_block);
+				}
+				return QueueOpStatus::closed;
+			}
+
+			const std::size_t offset = (tail >> shift) % lap;
+
+			// another producer is linking the next block
+			if(offset == block_capacity)
+			{
+				std::this_thread::yield();
+				tail = tail_.index.load(std::memory_order_acquire);
+				block = tail_.block.load(std::memory_order_acquire);
+				continue;
+			}
+
+			// allocate ahead of the CAS to keep the window in which others wait for the link short
+			if(offset + 1 == block_capacity && next_block == nullptr)
+			{
+				next_block = acquire_block();
+			}
+
+			// very first push installs the first block
+			if(block == nullptr)
+			{
+				Block* first = next_block != nullptr ? std::exchange(next_block, nullptr) : acquire_block();
+				if(tail_.block.compare_exchange_strong(block, first, std::memory_order_release, std::memory_order_relaxed))
+				{
+					head_.block.store(first, std::memory_order_release);
+					block = first;
+				}
+				else
+				{
+					next_block = first;
+					tail = tail_.index.load(std::memory_order_acquire);
+					block = tail_.block.load(std::memory_order_acquire);
+					continue;
+				}
+			}
+
+			const std::uint64_t new_tail = tail + (1 << shift);
+			if(tail_.index.compare_exchange_weak(tail, new_tail, std::memory_order_seq_cst, std::memory_order_acquire))
+			{
+				if(offset + 1 == block_capacity)
+				{
+					tail_.block.store(next_block, std::memory_order_release);
+					// skip the boundary position, keeping a concurrent close flag
+					tail_.index.fetch_add(1 << shift, std::memory_order_release);
+					block->next.store(next_block, std::memory_order_release);
+				}
+				else if(next_block != nullptr)
+				{
+					release_block(next_block);
+				}
+
+				Slot& slot = block->slots[offset];
+				std::construct_at(slot.value(), std::move(elem));
+				slot.state.fetch_or(slot_written, std::memory_order_release);
+
+				wake_sleepers();
+				return QueueOpStatus::success;
+			}
+
+			block = tail_.block.load(std::memory_order_acquire);
+		}
+	}
+
+	template<typename T>
+	template<typename Sink>
+	QueueOpStatus LockFreeLinkedQueue<T>::pop_impl(Sink&& sink)
+	{
+		std::uint64_t head = head_.index.load(std::memory_order_acquire);
+		Block* block = head_.block.load(std::memory_order_acquire);
+
+		while(true)
+		{
+			const std::size_t offset = (head >> shift) % lap;
+
+			// another consumer is moving to the next block
+			if(offset == block_capacity)
+			{
+				std::this_thread::yield();
+				head = head_.index.load(std::memory_order_acquire);
+				block = head_.block.load(std::memory_order_acquire);
+				continue;
+			}
+
+			std::uint64_t new_head = head + (1 << shift);
+			if((new_head & has_next) == 0)
+			{
+				// seq_cst pairs with the producer CAS and sleepers_ for the parking handshake
+				const std::uint64_t tail = tail_.index.load(std::memory_order_seq_cst);
+
+				if(head >> shift == tail >> shift)
+				{
+					return (tail & closed_bit) != 0 ? QueueOpStatus::closed : QueueOpStatus::empty;
+				}
+
+				if((head >> shift) / lap != (tail >> shift) / lap)
+				{
+					new_head |= has_next;
+				}
+			}
+
+			// first push is still installing the first block
+			if(block == nullptr)
+			{
+				std::this_thread::yield();
+				head = head_.index.load(std::memory_order_acquire);
+				block = head_.block.load(std::memory_order_acquire);
+				continue;
+			}
+
+			if(head_.index.compare_exchange_weak(head, new_head, std::memory_order_seq_cst, std::memory_order_acquire))
+			{
+				if(offset + 1 == block_capacity)
+				{
+					Block* next = wait_next(block);
+					std::uint64_t next_index = (new_head & ~has_next) + (1 << shift);
+					if(next->next.load(std::memory_order_relaxed) != nullptr)
+					{
+						next_index |= has_next;
+					}
+
+					head_.block.store(next, std::memory_order_release);
+					head_.index.store(next_index, std::memory_order_release);
+				}
+
+				Slot& slot = block->slots[offset];
+				wait_written(slot);
+				sink(std::move(*slot.value()));
+				std::destroy_at(slot.value());
+
+				if(offset + 1 == block_capacity)
+				{
+					destroy_block(block, 0);
+				}
+				else if((slot.state.fetch_or(slot_read, std::memory_order_acq_rel) & slot_destroy) != 0)
+				{
+					destroy_block(block, offset + 1);
+				}
+				return QueueOpStatus::success;
+			}
+
+			block = head_.block.load(std::memory_order_acquire);
+		}
+	}
+
+	template<typename T>
+	template<typename Sink, typename Clock, typename Duration>
+	QueueOpStatus LockFreeLinkedQueue<T>::wait_pop_impl(
+			Sink&& sink,
+			const std::optional<std::chrono::time_point<Clock, Duration>>& deadline
+	)
+	{
+		for(std::size_t spin = 0; spin < spin_limit; ++spin)
+		{
+			const QueueOpStatus status = pop_impl(sink);
+			if(status != QueueOpStatus::empty)
+			{
+				return status;
+			}
+			std::this_thread::yield();
+		}
+
+		while(true)
+		{
+			// announce before the last check, a producer either sees the sleeper or we see its element
+			sleepers_.fetch_add(1);
+			const QueueOpStatus status = pop_impl(sink);
+			if(status != QueueOpStatus::empty)
+			{
+				sleepers_.fetch_sub(1);
+				return status;
+			}
+
+			bool timed_out = false;
+			{
+				std::unique_lock lock(sleep_mutex_);
+				const auto ready = [this](){ return !empty() || closed(); };
+				if(deadline)
+				{
+					timed_out = !sleep_cv_.wait_until(lock, *deadline, ready);
+				}
+				else
+				{
+					sleep_cv_.wait(lock, ready);
+				}
+			}
+			sleepers_.fetch_sub(1);
+
+			if(timed_out)
+			{
+				return QueueOpStatus::timeout;
+			}
+		}
+	}
+
+	template<typename T>
+	void LockFreeLinkedQueue<T>::wake_sleepers() noexcept
+	{
+		if(sleepers_.load() == 0)
+		{
+			return;
+		}
+
+		{
+			std::scoped_lock lock(sleep_mutex_);
+		}
+		sleep_cv_.notify_one();
+	}
+}
+
+#endif //THREAD_POOL_LOCK_FREE_LINKED_QUEUE_HPP
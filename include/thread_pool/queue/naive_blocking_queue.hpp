@@ -2,25 +2,33 @@
 #define THREAD_POOL__NAIVE_BLOCKING_QUEUE_HPP
 
 #include "common.hpp"
+#include "thread_pool/detail/_queue_counters.hpp"
+#include "event_count.hpp"
 
 #include <mutex>
 #include <queue>
 #include <condition_variable>
+#include <chrono>
 #include <functional>
 
 
 namespace thread_pool
 {
-	template<typename T>
-	class NaiveBlockingQueue
+	/**
+	 * Unbounded queue guarded by a single mutex.
+	 *
+	 * Condition is std::condition_variable or EventCountCondition (see EventCountNaiveBlockingQueue).
+	 */
+	template<typename T, typename Condition>
+	class BasicNaiveBlockingQueue
 	{
 	public:
 		using value_type = T;
 
-		NaiveBlockingQueue();
+		BasicNaiveBlockingQueue();
 
-		NaiveBlockingQueue(const NaiveBlockingQueue&) = delete;
-		NaiveBlockingQueue& operator=(const NaiveBlockingQueue&) = delete;
+		BasicNaiveBlockingQueue(const BasicNaiveBlockingQueue&) = delete;
+		BasicNaiveBlockingQueue& operator=(const BasicNaiveBlockingQueue&) = delete;
 
 		void push(const value_type& elem);
 		void push(value_type&& elem);
@@ -31,12 +39,37 @@ namespace thread_pool
 		[[nodiscard]] QueueOpStatus wait_push(const value_type& elem);
 		[[nodiscard]] QueueOpStatus wait_push(value_type&& elem);
 
+		template<typename Rep, typename Period>
+		[[nodiscard]] QueueOpStatus wait_push_for(const value_type& elem, const std::chrono::duration<Rep, Period>& timeout);
+		template<typename Rep, typename Period>
+		[[nodiscard]] QueueOpStatus wait_push_for(value_type&& elem, const std::chrono::duration<Rep, Period>& timeout);
+
+		template<typename Clock, typename Duration>
+		[[nodiscard]] QueueOpStatus wait_push_until(
+				const value_type& elem,
+				const std::chrono::time_point<Clock, Duration>& deadline
+		);
+		template<typename Clock, typename Duration>
+		[[nodiscard]] QueueOpStatus wait_push_until(
+				value_type&& elem,
+				const std::chrono::time_point<Clock, Duration>& deadline
+		);
+
 		[[nodiscard]] value_type value_pop();
 
 		[[nodiscard]] QueueOpStatus try_pop(value_type& dest);
 
 		[[nodiscard]] QueueOpStatus wait_pop(value_type& dest);
 
+		template<typename Rep, typename Period>
+		[[nodiscard]] QueueOpStatus wait_pop_for(value_type& dest, const std::chrono::duration<Rep, Period>& timeout);
+
+		template<typename Clock, typename Duration>
+		[[nodiscard]] QueueOpStatus wait_pop_until(
+				value_type& dest,
+				const std::chrono::time_point<Clock, Duration>& deadline
+		);
+
 		void close() noexcept;
 		[[nodiscard]] bool closed() const noexcept;
 
@@ -45,21 +78,33 @@ namespace thread_pool
 
 		[[nodiscard]] std::size_t size() const noexcept;
 
+		/**
+		 * Approximate size, high-water mark and closed flag, read without taking the queue lock.
+		 */
+		[[nodiscard]] QueueStats stats() const noexcept;
+
 	private:
 		bool closed_;
 		mutable std::mutex queue_mutex_;
-		std::condition_variable consumers_cv_;
+		detail::QueueCounters counters_;
+		Condition consumers_cv_;
 		std::queue<T> queue_;
 	};
 
 	template<typename T>
-	NaiveBlockingQueue<T>::NaiveBlockingQueue()
+	using NaiveBlockingQueue = BasicNaiveBlockingQueue<T, std::condition_variable>;
+
+	template<typename T>
+	using EventCountNaiveBlockingQueue = BasicNaiveBlockingQueue<T, EventCountCondition>;
+
+	template<typename T, typename Condition>
+	BasicNaiveBlockingQueue<T, Condition>::BasicNaiveBlockingQueue()
 			:
 			closed_(false)
 	{}
 
-	template<typename T>
-	void NaiveBlockingQueue<T>::push(const value_type& elem)
+	template<typename T, typename Condition>
+	void BasicNaiveBlockingQueue<T, Condition>::push(const value_type& elem)
 	{
 		if(wait_push(elem) == QueueOpStatus::closed)
 		{
@@ -67,8 +112,8 @@ namespace thread_pool
 		}
 	}
 
-	template<typename T>
-	void NaiveBlockingQueue<T>::push(value_type&& elem)
+	template<typename T, typename Condition>
+	void BasicNaiveBlockingQueue<T, Condition>::push(value_type&& elem)
 	{
 		if(wait_push(std::move(elem)) == QueueOpStatus::closed)
 		{
@@ -76,20 +121,20 @@ namespace thread_pool
 		}
 	}
 
-	template<typename T>
-	QueueOpStatus NaiveBlockingQueue<T>::try_push(const value_type& elem)
+	template<typename T, typename Condition>
+	QueueOpStatus BasicNaiveBlockingQueue<T, Condition>::try_push(const value_type& elem)
 	{
 		return wait_push(elem);
 	}
 
-	template<typename T>
-	QueueOpStatus NaiveBlockingQueue<T>::try_push(value_type&& elem)
+	template<typename T, typename Condition>
+	QueueOpStatus BasicNaiveBlockingQueue<T, Condition>::try_push(value_type&& elem)
 	{
 		return wait_push(std::move(elem));
 	}
 
-	template<typename T>
-	QueueOpStatus NaiveBlockingQueue<T>::wait_push(const value_type& elem)
+	template<typename T, typename Condition>
+	QueueOpStatus BasicNaiveBlockingQueue<T, Condition>::wait_push(const value_type& elem)
 	{
 		{
 			std::unique_lock queue_lock(queue_mutex_);
@@ -99,14 +144,15 @@ namespace thread_pool
 			}
 
 			queue_.push(elem);
+			counters_.on_push();
 		}
 		consumers_cv_.notify_one();
 
 		return QueueOpStatus::success;
 	}
 
-	template<typename T>
-	QueueOpStatus NaiveBlockingQueue<T>::wait_push(value_type&& elem)
+	template<typename T, typename Condition>
+	QueueOpStatus BasicNaiveBlockingQueue<T, Condition>::wait_push(value_type&& elem)
 	{
 		{
 			std::unique_lock queue_lock(queue_mutex_);
@@ -117,14 +163,49 @@ namespace thread_pool
 			}
 
 			queue_.push(std::move(elem));
+			counters_.on_push();
 		}
 		consumers_cv_.notify_one();
 
 		return QueueOpStatus::success;
 	}
 
-	template<typename T>
-	typename NaiveBlockingQueue<T>::value_type NaiveBlockingQueue<T>::value_pop()
+	template<typename T, typename Condition>
+	template<typename Rep, typename Period>
+	QueueOpStatus BasicNaiveBlockingQueue<T, Condition>::wait_push_for(const value_type& elem, const std::chrono::duration<Rep, Period>&)
+	{
+		return wait_push(elem);
+	}
+
+	template<typename T, typename Condition>
+	template<typename Rep, typename Period>
+	QueueOpStatus BasicNaiveBlockingQueue<T, Condition>::wait_push_for(value_type&& elem, const std::chrono::duration<Rep, Period>&)
+	{
+		return wait_push(std::move(elem));
+	}
+
+	template<typename T, typename Condition>
+	template<typename Clock, typename Duration>
+	QueueOpStatus BasicNaiveBlockingQueue<T, Condition>::wait_push_until(
+			const value_type& elem,
+			const std::chrono::time_point<Clock, Duration>&
+	)
+	{
+		return wait_push(elem);
+	}
+
+	template<typename T, typename Condition>
+	template<typename Clock, typename Duration>
+	QueueOpStatus BasicNaiveBlockingQueue<T, Condition>::wait_push_until(
+			value_type&& elem,
+			const std::chrono::time_point<Clock, Duration>&
+	)
+	{
+		return wait_push(std::move(elem));
+	}
+
+	template<typename T, typename Condition>
+	typename BasicNaiveBlockingQueue<T, Condition>::value_type BasicNaiveBlockingQueue<T, Condition>::value_pop()
 	{
 		value_type elem;
 		if(wait_pop(elem) == QueueOpStatus::closed)
@@ -135,8 +216,8 @@ namespace thread_pool
 		return elem;
 	}
 
-	template<typename T>
-	QueueOpStatus NaiveBlockingQueue<T>::try_pop(value_type& dest)
+	template<typename T, typename Condition>
+	QueueOpStatus BasicNaiveBlockingQueue<T, Condition>::try_pop(value_type& dest)
 	{
 		{
 			std::unique_lock queue_lock(queue_mutex_);
@@ -154,12 +235,13 @@ namespace thread_pool
 
 			dest = std::move(queue_.front());
 			queue_.pop();
+			counters_.on_pop();
 		}
 		return QueueOpStatus::success;
 	}
 
-	template<typename T>
-	QueueOpStatus NaiveBlockingQueue<T>::wait_pop(value_type& dest)
+	template<typename T, typename Condition>
+	QueueOpStatus BasicNaiveBlockingQueue<T, Condition>::wait_pop(value_type& dest)
 	{
 		{
 			std::unique_lock queue_lock(queue_mutex_);
@@ -181,47 +263,100 @@ namespace thread_pool
 			{
 				dest = std::move(queue_.front());
 				queue_.pop();
+				counters_.on_pop();
 			}
 		}
 		return QueueOpStatus::success;
 	}
 
-	template<typename T>
-	void NaiveBlockingQueue<T>::close() noexcept
+	template<typename T, typename Condition>
+	template<typename Rep, typename Period>
+	QueueOpStatus BasicNaiveBlockingQueue<T, Condition>::wait_pop_for(value_type& dest, const std::chrono::duration<Rep, Period>& timeout)
+	{
+		return wait_pop_until(dest, std::chrono::steady_clock::now() + timeout);
+	}
+
+	template<typename T, typename Condition>
+	template<typename Clock, typename Duration>
+	QueueOpStatus BasicNaiveBlockingQueue<T, Condition>::wait_pop_until(
+			value_type& dest,
+			const std::chrono::time_point<Clock, Duration>& deadline
+	)
+	{
+		{
+			std::unique_lock queue_lock(queue_mutex_);
+
+			const bool ready = consumers_cv_.wait_until(
+				queue_lock,
+				deadline,
+				[&]()
+				{
+					return !queue_.empty() or closed_;
+				}
+			);
+
+			if(!ready)
+			{
+				return QueueOpStatus::timeout;
+			}
+
+			if(queue_.empty())
+			{
+				return QueueOpStatus::closed;
+			}
+			else
+			{
+				dest = std::move(queue_.front());
+				queue_.pop();
+				counters_.on_pop();
+			}
+		}
+		return QueueOpStatus::success;
+	}
+
+	template<typename T, typename Condition>
+	void BasicNaiveBlockingQueue<T, Condition>::close() noexcept
 	{
 		{
 			std::unique_lock queue_lock(queue_mutex_);
 			closed_ = true;
+			counters_.on_close();
 		}
 		consumers_cv_.notify_all();
 	}
 
-	template<typename T>
-	bool NaiveBlockingQueue<T>::closed() const noexcept
+	template<typename T, typename Condition>
+	bool BasicNaiveBlockingQueue<T, Condition>::closed() const noexcept
 	{
 		std::unique_lock queue_lock(queue_mutex_);
 		return closed_;
 	}
 
-	template<typename T>
-	bool NaiveBlockingQueue<T>::empty() const noexcept
+	template<typename T, typename Condition>
+	bool BasicNaiveBlockingQueue<T, Condition>::empty() const noexcept
 	{
 		std::unique_lock queue_lock(queue_mutex_);
 		return queue_.empty();
 	}
 
-	template<typename T>
-	bool NaiveBlockingQueue<T>::full() const noexcept
+	template<typename T, typename Condition>
+	bool BasicNaiveBlockingQueue<T, Condition>::full() const noexcept
 	{
 		return false;
 	}
 
-	template<typename T>
-	std::size_t NaiveBlockingQueue<T>::size() const noexcept
+	template<typename T, typename Condition>
+	std::size_t BasicNaiveBlockingQueue<T, Condition>::size() const noexcept
 	{
 		std::unique_lock queue_lock(queue_mutex_);
 		return queue_.size();
 	}
+
+	template<typename T, typename Condition>
+	QueueStats BasicNaiveBlockingQueue<T, Condition>::stats() const noexcept
+	{
+		return counters_.snapshot();
+	}
 }
 
 #endif //THREAD_POOL__NAIVE_BLOCKING_QUEUE_HPP
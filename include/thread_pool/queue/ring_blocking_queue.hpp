@@ -1,24 +1,40 @@
 #ifndef THREAD_POOL_RING_BLOCKING_QUEUE_HPP
 #define THREAD_POOL_RING_BLOCKING_QUEUE_HPP
 
+#include <algorithm>
 #include <memory>
 #include <mutex>
 #include <condition_variable>
+#include <chrono>
+#include <stdexcept>
 #include "common.hpp"
+#include "thread_pool/detail/_queue_counters.hpp"
+#include "thread_pool/detail/_prefault.hpp"
+#include "event_count.hpp"
 
 
 namespace thread_pool
 {
-	template<typename T>
-	class RingBlockingQueue
+	/**
+	 * Bounded queue backed by a ring of raw storage.
+	 *
+	 * Elements are constructed in place on push and destroyed on pop, so value_type does not
+	 * have to be default constructible. An exception thrown while copying/moving an element
+	 * leaves the queue open and unchanged (the element stays in the queue on a failed pop).
+	 *
+	 * Condition is std::condition_variable or EventCountCondition (see EventCountRingBlockingQueue).
+	 */
+	template<typename T, typename Condition>
+	class BasicRingBlockingQueue
 	{
 	public:
 		using value_type = T;
 
-		explicit RingBlockingQueue(std::size_t size);
+		explicit BasicRingBlockingQueue(std::size_t size);
+		~BasicRingBlockingQueue();
 
-		RingBlockingQueue(const RingBlockingQueue&) = delete;
-		RingBlockingQueue& operator=(const RingBlockingQueue&) = delete;
+		BasicRingBlockingQueue(const BasicRingBlockingQueue&) = delete;
+		BasicRingBlockingQueue& operator=(const BasicRingBlockingQueue&) = delete;
 
 		void push(const value_type& elem);
 		void push(value_type&& elem);
@@ -29,12 +45,37 @@ namespace thread_pool
 		[[nodiscard]] QueueOpStatus wait_push(const value_type& elem);
 		[[nodiscard]] QueueOpStatus wait_push(value_type&& elem);
 
+		template<typename Rep, typename Period>
+		[[nodiscard]] QueueOpStatus wait_push_for(const value_type& elem, const std::chrono::duration<Rep, Period>& timeout);
+		template<typename Rep, typename Period>
+		[[nodiscard]] QueueOpStatus wait_push_for(value_type&& elem, const std::chrono::duration<Rep, Period>& timeout);
+
+		template<typename Clock, typename Duration>
+		[[nodiscard]] QueueOpStatus wait_push_until(
+				const value_type& elem,
+				const std::chrono::time_point<Clock, Duration>& deadline
+		);
+		template<typename Clock, typename Duration>
+		[[nodiscard]] QueueOpStatus wait_push_until(
+				value_type&& elem,
+				const std::chrono::time_point<Clock, Duration>& deadline
+		);
+
 		[[nodiscard]] value_type value_pop();
 
 		[[nodiscard]] QueueOpStatus try_pop(value_type& dest);
 
 		[[nodiscard]] QueueOpStatus wait_pop(value_type& dest);
 
+		template<typename Rep, typename Period>
+		[[nodiscard]] QueueOpStatus wait_pop_for(value_type& dest, const std::chrono::duration<Rep, Period>& timeout);
+
+		template<typename Clock, typename Duration>
+		[[nodiscard]] QueueOpStatus wait_pop_until(
+				value_type& dest,
+				const std::chrono::time_point<Clock, Duration>& deadline
+		);
+
 		void close() noexcept;
 		[[nodiscard]] bool closed() const noexcept;
 
@@ -43,33 +84,73 @@ namespace thread_pool
 
 		[[nodiscard]] std::size_t capacity() const noexcept;
 
+		/**
+		 * Prefaults the buffer slots the next count pushes will use (the buffer itself is allocated up front).
+		 */
+		void reserve(std::size_t count);
+
+		/**
+		 * Approximate size, high-water mark and closed flag, read without taking the queue lock.
+		 */
+		[[nodiscard]] QueueStats stats() const noexcept;
+
 	private:
 		bool closed_ = false;
 		mutable std::mutex queue_mutex_;
-		std::condition_variable consumer_cv_;
-		std::condition_variable producer_cv_;
-		std::unique_ptr<value_type[]> buffer_;
+		detail::QueueCounters counters_;
+		Condition consumer_cv_;
+		Condition producer_cv_;
 
 		std::size_t capacity_;
+		std::allocator<value_type> allocator_;
+		value_type* buffer_;
+
 		std::size_t head_ = 0;
 		std::size_t tail_ = 0;
 
 		inline std::size_t next_index(std::size_t index) const;
 
+		template<typename U>
+		QueueOpStatus try_push_impl(U&& elem);
+		template<typename U>
+		QueueOpStatus wait_push_impl(U&& elem);
+		template<typename U, typename Clock, typename Duration>
+		QueueOpStatus wait_push_until_impl(U&& elem, const std::chrono::time_point<Clock, Duration>& deadline);
+
+		template<typename U>
+		void emplace_head(U&& elem);
+		void pop_tail(value_type& dest);
+
 		static size_t check_size(size_t size);
 	};
 
 	template<typename T>
-	RingBlockingQueue<T>::RingBlockingQueue(std::size_t size)
+	using RingBlockingQueue = BasicRingBlockingQueue<T, std::condition_variable>;
+
+	template<typename T>
+	using EventCountRingBlockingQueue = BasicRingBlockingQueue<T, EventCountCondition>;
+
+	template<typename T, typename Condition>
+	BasicRingBlockingQueue<T, Condition>::BasicRingBlockingQueue(std::size_t size)
 	:
-		buffer_(std::make_unique<T[]>(check_size(size))),
-		capacity_(size+1)
+		capacity_(check_size(size)),
+		buffer_(allocator_.allocate(capacity_))
 	{
 
 	}
 
-	template<typename T>
-	std::size_t RingBlockingQueue<T>::next_index(std::size_t index) const
+	template<typename T, typename Condition>
+	BasicRingBlockingQueue<T, Condition>::~BasicRingBlockingQueue()
+	{
+		for(std::size_t index = tail_; index != head_; index = next_index(index))
+		{
+			std::destroy_at(buffer_ + index);
+		}
+		allocator_.deallocate(buffer_, capacity_);
+	}
+
+	template<typename T, typename Condition>
+	std::size_t BasicRingBlockingQueue<T, Condition>::next_index(std::size_t index) const
 	{
 		std::size_t next = ++index;
 		if(next == capacity_)
@@ -79,8 +160,28 @@ namespace thread_pool
 		return next;
 	}
 
-	template<typename T>
-	void RingBlockingQueue<T>::push(const value_type& elem)
+	template<typename T, typename Condition>
+	template<typename U>
+	void BasicRingBlockingQueue<T, Condition>::emplace_head(U&& elem)
+	{
+		// head_ is advanced only after successful construction
+		std::construct_at(buffer_ + head_, std::forward<U>(elem));
+		head_ = next_index(head_);
+		counters_.on_push();
+	}
+
+	template<typename T, typename Condition>
+	void BasicRingBlockingQueue<T, Condition>::pop_tail(value_type& dest)
+	{
+		// tail_ is advanced only after successful assignment
+		dest = std::move(buffer_[tail_]);
+		std::destroy_at(buffer_ + tail_);
+		tail_ = next_index(tail_);
+		counters_.on_pop();
+	}
+
+	template<typename T, typename Condition>
+	void BasicRingBlockingQueue<T, Condition>::push(const value_type& elem)
 	{
 		if(wait_push(elem) == QueueOpStatus::closed)
 		{
@@ -88,293 +189,318 @@ namespace thread_pool
 		}
 	}
 
-	template<typename T>
-	void RingBlockingQueue<T>::push(value_type&& elem)
+	template<typename T, typename Condition>
+	void BasicRingBlockingQueue<T, Condition>::push(value_type&& elem)
 	{
-		if(wait_push(std::forward<value_type>(elem)) == QueueOpStatus::closed)
+		if(wait_push(std::move(elem)) == QueueOpStatus::closed)
 		{
 			throw QueueClosedException();
 		}
 	}
 
-	template<typename T>
-	QueueOpStatus RingBlockingQueue<T>::try_push(const value_type& elem)
+	template<typename T, typename Condition>
+	QueueOpStatus BasicRingBlockingQueue<T, Condition>::try_push(const value_type& elem)
 	{
-		try
-		{
-			{
-				std::scoped_lock lock(queue_mutex_);
-				if(closed_)
-				{
-					return QueueOpStatus::closed;
-				}
+		return try_push_impl(elem);
+	}
 
-				std::size_t curr_push_index = head_;
-				std::size_t next_push_index = next_index(head_);
+	template<typename T, typename Condition>
+	QueueOpStatus BasicRingBlockingQueue<T, Condition>::try_push(value_type&& elem)
+	{
+		return try_push_impl(std::move(elem));
+	}
 
-				if(next_push_index == tail_)
-				{
-					return QueueOpStatus::full;
-				}
+	template<typename T, typename Condition>
+	template<typename U>
+	QueueOpStatus BasicRingBlockingQueue<T, Condition>::try_push_impl(U&& elem)
+	{
+		{
+			std::scoped_lock lock(queue_mutex_);
+			if(closed_)
+			{
+				return QueueOpStatus::closed;
+			}
 
-				head_ = next_push_index;
-				buffer_[curr_push_index] = elem;
+			if(next_index(head_) == tail_)
+			{
+				return QueueOpStatus::full;
 			}
 
-			consumer_cv_.notify_one();
-		}
-		catch (...)
-		{
-			close();
-			throw;
+			emplace_head(std::forward<U>(elem));
 		}
 
+		consumer_cv_.notify_one();
 		return QueueOpStatus::success;
 	}
 
-	template<typename T>
-	QueueOpStatus RingBlockingQueue<T>::try_push(value_type&& elem)
+	template<typename T, typename Condition>
+	QueueOpStatus BasicRingBlockingQueue<T, Condition>::wait_push(const value_type& elem)
+	{
+		return wait_push_impl(elem);
+	}
+
+	template<typename T, typename Condition>
+	QueueOpStatus BasicRingBlockingQueue<T, Condition>::wait_push(value_type&& elem)
+	{
+		return wait_push_impl(std::move(elem));
+	}
+
+	template<typename T, typename Condition>
+	template<typename U>
+	QueueOpStatus BasicRingBlockingQueue<T, Condition>::wait_push_impl(U&& elem)
 	{
-		try
 		{
+			std::unique_lock<std::mutex> lock(queue_mutex_);
+
+			while(true)
 			{
-				std::scoped_lock lock(queue_mutex_);
 				if(closed_)
 				{
 					return QueueOpStatus::closed;
 				}
 
-				std::size_t curr_push_index = head_;
-				std::size_t next_push_index = next_index(head_);
-
-				if(next_push_index == tail_)
+				if(next_index(head_) != tail_)
 				{
-					return QueueOpStatus::full;
+					break;
 				}
-
-				head_ = next_push_index;
-				buffer_[curr_push_index] = std::move(elem);
+				producer_cv_.wait(lock);
 			}
 
-			consumer_cv_.notify_one();
-		}
-		catch (...)
-		{
-			close();
-			throw;
+			emplace_head(std::forward<U>(elem));
 		}
 
+		consumer_cv_.notify_one();
 		return QueueOpStatus::success;
 	}
 
+	template<typename T, typename Condition>
+	template<typename Rep, typename Period>
+	QueueOpStatus BasicRingBlockingQueue<T, Condition>::wait_push_for(
+			const value_type& elem,
+			const std::chrono::duration<Rep, Period>& timeout
+	)
+	{
+		return wait_push_until_impl(elem, std::chrono::steady_clock::now() + timeout);
+	}
 
-	template<typename T>
-	QueueOpStatus RingBlockingQueue<T>::wait_push(const value_type& elem)
+	template<typename T, typename Condition>
+	template<typename Rep, typename Period>
+	QueueOpStatus BasicRingBlockingQueue<T, Condition>::wait_push_for(
+			value_type&& elem,
+			const std::chrono::duration<Rep, Period>& timeout
+	)
+	{
+		return wait_push_until_impl(std::move(elem), std::chrono::steady_clock::now() + timeout);
+	}
+
+	template<typename T, typename Condition>
+	template<typename Clock, typename Duration>
+	QueueOpStatus BasicRingBlockingQueue<T, Condition>::wait_push_until(
+			const value_type& elem,
+			const std::chrono::time_point<Clock, Duration>& deadline
+	)
+	{
+		return wait_push_until_impl(elem, deadline);
+	}
+
+	template<typename T, typename Condition>
+	template<typename Clock, typename Duration>
+	QueueOpStatus BasicRingBlockingQueue<T, Condition>::wait_push_until(
+			value_type&& elem,
+			const std::chrono::time_point<Clock, Duration>& deadline
+	)
+	{
+		return wait_push_until_impl(std::move(elem), deadline);
+	}
+
+	template<typename T, typename Condition>
+	template<typename U, typename Clock, typename Duration>
+	QueueOpStatus BasicRingBlockingQueue<T, Condition>::wait_push_until_impl(
+			U&& elem,
+			const std::chrono::time_point<Clock, Duration>& deadline
+	)
 	{
-		try
 		{
-			{
-				std::unique_lock<std::mutex> lock(queue_mutex_);
+			std::unique_lock<std::mutex> lock(queue_mutex_);
 
-				std::size_t curr_push_index;
-				std::size_t next_push_index;
+			while(true)
+			{
+				if(closed_)
+				{
+					return QueueOpStatus::closed;
+				}
 
-				while(true)
+				if(next_index(head_) != tail_)
 				{
-					if(closed_)
-					{
-						return QueueOpStatus::closed;
-					}
-
-					curr_push_index = head_;
-					next_push_index = next_index(head_);
-
-					if(next_push_index != tail_)
-					{
-						break;
-					}
-					producer_cv_.wait(lock);
+					break;
 				}
 
-				head_ = next_push_index;
-				buffer_[curr_push_index] = elem;
+				if(Clock::now() >= deadline)
+				{
+					return QueueOpStatus::timeout;
+				}
+				producer_cv_.wait_until(lock, deadline);
 			}
 
-			consumer_cv_.notify_one();
-		}
-		catch (...)
-		{
-			close();
-			throw;
+			emplace_head(std::forward<U>(elem));
 		}
 
+		consumer_cv_.notify_one();
 		return QueueOpStatus::success;
 	}
 
-	template<typename T>
-	QueueOpStatus RingBlockingQueue<T>::wait_push(value_type&& elem)
+	template<typename T, typename Condition>
+	typename BasicRingBlockingQueue<T, Condition>::value_type BasicRingBlockingQueue<T, Condition>::value_pop()
 	{
-		try
+		std::unique_lock<std::mutex> lock(queue_mutex_);
+
+		while(head_ == tail_)
 		{
+			if(closed_)
 			{
-				std::unique_lock<std::mutex> lock(queue_mutex_);
+				throw QueueClosedException();
+			}
+			consumer_cv_.wait(lock);
+		}
+
+		value_type elem(std::move(buffer_[tail_]));
+		std::destroy_at(buffer_ + tail_);
+		tail_ = next_index(tail_);
+		counters_.on_pop();
 
-				std::size_t curr_push_index;
-				std::size_t next_push_index;
+		lock.unlock();
+		producer_cv_.notify_one();
+
+		return elem;
+	}
+
+	template<typename T, typename Condition>
+	QueueOpStatus BasicRingBlockingQueue<T, Condition>::try_pop(value_type& dest)
+	{
+		{
+			std::lock_guard<std::mutex> lock(queue_mutex_);
 
-				while(true)
+			if(head_ == tail_)
+			{
+				if(closed_)
 				{
-					if(closed_)
-					{
-						return QueueOpStatus::closed;
-					}
-
-					curr_push_index = head_;
-					next_push_index = next_index(head_);
-
-					if(next_push_index != tail_)
-					{
-						break;
-					}
-					producer_cv_.wait(lock);
+					return QueueOpStatus::closed;
+				}
+				else
+				{
+					return QueueOpStatus::empty;
 				}
-
-				buffer_[curr_push_index] = std::move(elem);
-				head_ = next_push_index;
 			}
 
-			consumer_cv_.notify_one();
-		}
-		catch (...)
-		{
-			close();
-			throw;
+			pop_tail(dest);
 		}
 
+		producer_cv_.notify_one();
 		return QueueOpStatus::success;
 	}
 
-	template<typename T>
-	typename RingBlockingQueue<T>::value_type RingBlockingQueue<T>::value_pop()
+	template<typename T, typename Condition>
+	QueueOpStatus BasicRingBlockingQueue<T, Condition>::wait_pop(value_type& dest)
 	{
-		value_type elem;
-		if(wait_pop(elem) == QueueOpStatus::closed)
 		{
-			throw QueueClosedException();
-		}
-
-		return elem;
-	}
+			std::unique_lock<std::mutex> lock(queue_mutex_);
 
-	template<typename T>
-	QueueOpStatus RingBlockingQueue<T>::try_pop(value_type& dest)
-	{
-		try
-		{
+			while(head_ == tail_)
 			{
-				std::lock_guard<std::mutex> lock(queue_mutex_);
-
-				if(head_ == tail_)
+				if(closed_)
 				{
-					if(closed_)
-					{
-						return QueueOpStatus::closed;
-					}
-					else
-					{
-						return QueueOpStatus::empty;
-					}
+					return QueueOpStatus::closed;
 				}
-				std::size_t curr_pop_index = tail_;
-				tail_ = next_index(curr_pop_index);
-
-				dest = std::move(buffer_[curr_pop_index]);
+				consumer_cv_.wait(lock);
 			}
 
-			producer_cv_.notify_one();
-			return QueueOpStatus::success;
-		}
-		catch (...)
-		{
-			close();
-			throw;
+			pop_tail(dest);
 		}
+
+		producer_cv_.notify_one();
+		return QueueOpStatus::success;
 	}
 
-	template<typename T>
-	QueueOpStatus RingBlockingQueue<T>::wait_pop(value_type& dest)
+	template<typename T, typename Condition>
+	template<typename Rep, typename Period>
+	QueueOpStatus BasicRingBlockingQueue<T, Condition>::wait_pop_for(value_type& dest, const std::chrono::duration<Rep, Period>& timeout)
+	{
+		return wait_pop_until(dest, std::chrono::steady_clock::now() + timeout);
+	}
+
+	template<typename T, typename Condition>
+	template<typename Clock, typename Duration>
+	QueueOpStatus BasicRingBlockingQueue<T, Condition>::wait_pop_until(
+			value_type& dest,
+			const std::chrono::time_point<Clock, Duration>& deadline
+	)
 	{
-		try
 		{
-			{
-				std::unique_lock<std::mutex> lock(queue_mutex_);
+			std::unique_lock<std::mutex> lock(queue_mutex_);
 
-				while(head_ == tail_)
+			while(head_ == tail_)
+			{
+				if(closed_)
 				{
-					if(closed_)
-					{
-						return QueueOpStatus::closed;
-					}
-					consumer_cv_.wait(lock);
+					return QueueOpStatus::closed;
 				}
 
-				std::size_t curr_pop_index = tail_;
-				tail_ = next_index(curr_pop_index);
-
-				dest = std::move(buffer_[curr_pop_index]);
+				if(Clock::now() >= deadline)
+				{
+					return QueueOpStatus::timeout;
+				}
+				consumer_cv_.wait_until(lock, deadline);
 			}
 
-			producer_cv_.notify_one();
-			return QueueOpStatus::success;
-		}
-		catch (...)
-		{
-			close();
-			throw;
+			pop_tail(dest);
 		}
+
+		producer_cv_.notify_one();
+		return QueueOpStatus::success;
 	}
 
-	template<typename T>
-	void RingBlockingQueue<T>::close() noexcept
+	template<typename T, typename Condition>
+	void BasicRingBlockingQueue<T, Condition>::close() noexcept
 	{
 		{
 			std::scoped_lock queue_lock(queue_mutex_);
 			closed_ = true;
+			counters_.on_close();
 		}
 
 		consumer_cv_.notify_all();
 		producer_cv_.notify_all();
 	}
 
-	template<typename T>
-	bool RingBlockingQueue<T>::closed() const noexcept
+	template<typename T, typename Condition>
+	bool BasicRingBlockingQueue<T, Condition>::closed() const noexcept
 	{
 		std::scoped_lock queue_lock(queue_mutex_);
 		return closed_;
 	}
 
-	template<typename T>
-	bool RingBlockingQueue<T>::empty() const noexcept
+	template<typename T, typename Condition>
+	bool BasicRingBlockingQueue<T, Condition>::empty() const noexcept
 	{
 		std::scoped_lock queue_lock(queue_mutex_);
 		return tail_ == head_;
 	}
 
-	template<typename T>
-	bool RingBlockingQueue<T>::full() const noexcept
+	template<typename T, typename Condition>
+	bool BasicRingBlockingQueue<T, Condition>::full() const noexcept
 	{
 		std::scoped_lock queue_lock(queue_mutex_);
 		return next_index(head_) == tail_;
 	}
 
-	template<typename T>
-	std::size_t RingBlockingQueue<T>::capacity() const noexcept
+	template<typename T, typename Condition>
+	std::size_t BasicRingBlockingQueue<T, Condition>::capacity() const noexcept
 	{
 		return capacity_-1;
 	}
 
-	template<typename T>
-	size_t RingBlockingQueue<T>::check_size(size_t size)
+	template<typename T, typename Condition>
+	size_t BasicRingBlockingQueue<T, Condition>::check_size(size_t size)
 	{
 		if(size == 0)
 		{
@@ -382,6 +508,25 @@ namespace thread_pool
 		}
 		return size + 1;
 	}
+
+	template<typename T, typename Condition>
+	void BasicRingBlockingQueue<T, Condition>::reserve(std::size_t count)
+	{
+		std::scoped_lock queue_lock(queue_mutex_);
+
+		// only free slots, starting at head_, are touched
+		const std::size_t used = (head_ + capacity_ - tail_) % capacity_;
+		count = std::min(count, capacity_ - used);
+		const std::size_t first = std::min(count, capacity_ - head_);
+		detail::prefault(buffer_ + head_, first * sizeof(value_type));
+		detail::prefault(buffer_, (count - first) * sizeof(value_type));
+	}
+
+	template<typename T, typename Condition>
+	QueueStats BasicRingBlockingQueue<T, Condition>::stats() const noexcept
+	{
+		return counters_.snapshot();
+	}
 }
 
 #endif //THREAD_POOL_RING_BLOCKING_QUEUE_HPP
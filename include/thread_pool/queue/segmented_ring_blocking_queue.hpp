@@ -0,0 +1,655 @@
+#ifndef THREAD_POOL_SEGMENTED_RING_BLOCKING_QUEUE_HPP
+#define THREAD_POOL_SEGMENTED_RING_BLOCKING_QUEUE_HPP
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <condition_variable>
+#include <chrono>
+#include <stdexcept>
+#include "common.hpp"
+#include "thread_pool/detail/_queue_counters.hpp"
+#include "thread_pool/detail/_prefault.hpp"
+
+
+namespace thread_pool
+{
+	/**
+	 * Bounded queue which allocates its storage lazily in fixed-size segments.
+	 *
+	 * Segments are allocated when the queue grows into them and recycled once drained.
+	 * Recycled segments are released after release_threshold consecutive pops done while
+	 * the queue fits in a single segment, so memory usage follows the actual queue depth.
+	 */
+	template<typename T>
+	class SegmentedRingBlockingQueue
+	{
+	public:
+		using value_type = T;
+
+		static constexpr std::size_t default_segment_size = 256;
+
+		explicit SegmentedRingBlockingQueue(std::size_t size, std::size_t segment_size = default_segment_size);
+		~SegmentedRingBlockingQueue();
+
+		SegmentedRingBlockingQueue(const SegmentedRingBlockingQueue&) = delete;
+		SegmentedRingBlockingQueue& operator=(const SegmentedRingBlockingQueue&) = delete;
+
+		void push(const value_type& elem);
+		void push(value_type&& elem);
+
+		QueueOpStatus try_push(const value_type& elem);
+		QueueOpStatus try_push(value_type&& elem);
+
+		[[nodiscard]] QueueOpStatus wait_push(const value_type& elem);
+		[[nodiscard]] QueueOpStatus wait_push(value_type&& elem);
+
+		template<typename Rep, typename Period>
+		[[nodiscard]] QueueOpStatus wait_push_for(const value_type& elem, const std::chrono::duration<Rep, Period>& timeout);
+		template<typename Rep, typename Period>
+		[[nodiscard]] QueueOpStatus wait_push_for(value_type&& elem, const std::chrono::duration<Rep, Period>& timeout);
+
+		template<typename Clock, typename Duration>
+		[[nodiscard]] QueueOpStatus wait_push_until(
+				const value_type& elem,
+				const std::chrono::time_point<Clock, Duration>& deadline
+		);
+		template<typename Clock, typename Duration>
+		[[nodiscard]] QueueOpStatus wait_push_until(
+				value_type&& elem,
+				const std::chrono::time_point<Clock, Duration>& deadline
+		);
+
+		[[nodiscard]] value_type value_pop();
+
+		[[nodiscard]] QueueOpStatus try_pop(value_type& dest);
+
+		[[nodiscard]] QueueOpStatus wait_pop(value_type& dest);
+
+		template<typename Rep, typename Period>
+		[[nodiscard]] QueueOpStatus wait_pop_for(value_type& dest, const std::chrono::duration<Rep, Period>& timeout);
+
+		template<typename Clock, typename Duration>
+		[[nodiscard]] QueueOpStatus wait_pop_until(
+				value_type& dest,
+				const std::chrono::time_point<Clock, Duration>& deadline
+		);
+
+		void close() noexcept;
+		[[nodiscard]] bool closed() const noexcept;
+
+		[[nodiscard]] bool empty() const noexcept;
+		[[nodiscard]] bool full() const noexcept;
+
+		[[nodiscard]] std::size_t size() const noexcept;
+		[[nodiscard]] std::size_t capacity() const noexcept;
+
+		[[nodiscard]] std::size_t segment_size() const noexcept;
+		[[nodiscard]] std::size_t allocated_segments() const noexcept;
+
+		/**
+		 * Allocates and prefaults spare segments for count elements (up to capacity). A queue which later
+		 * stays almost empty for long trims them again.
+		 */
+		void reserve(std::size_t count);
+
+		/**
+		 * Approximate size, high-water mark and closed flag, read without taking the queue lock.
+		 */
+		[[nodiscard]] QueueStats stats() const noexcept;
+
+	private:
+		bool closed_ = false;
+		mutable std::mutex queue_mutex_;
+		detail::QueueCounters counters_;
+		std::condition_variable consumer_cv_;
+		std::condition_variable producer_cv_;
+
+		std::size_t capacity_;
+		std::size_t segment_size_;
+		std::size_t release_threshold_;
+		std::allocator<value_type> allocator_;
+
+		std::vector<value_type*> segments_;
+		std::vector<value_type*> spare_segments_;
+		std::size_t allocated_segments_ = 0;
+		std::size_t low_occupancy_pops_ = 0;
+
+		// logical positions, slot of position p is segments_[p / segment_size_ % segments_.size()]
+		std::size_t head_ = 0;
+		std::size_t tail_ = 0;
+
+		value_type* slot(std::size_t position) const noexcept;
+		value_type*& segment_of(std::size_t position) noexcept;
+
+		value_type* acquire_segment();
+		void release_segment(value_type*& segment) noexcept;
+		void trim_spare_segments() noexcept;
+
+		template<typename U>
+		QueueOpStatus try_push_impl(U&& elem);
+		template<typename U>
+		QueueOpStatus wait_push_impl(U&& elem);
+		template<typename U, typename Clock, typename Duration>
+		QueueOpStatus wait_push_until_impl(U&& elem, const std::chrono::time_point<Clock, Duration>& deadline);
+
+		template<typename U>
+		void emplace_head(U&& elem);
+		void advance_tail() noexcept;
+
+		static size_t check_size(size_t size);
+	};
+
+	template<typename T>
+	SegmentedRingBlockingQueue<T>::SegmentedRingBlockingQueue(std::size_t size, std::size_t segment_size)
+	:
+		capacity_(check_size(size)),
+		segment_size_(check_size(segment_size)),
+		release_threshold_(4 * segment_size_),
+		segments_((capacity_ + segment_size_ - 1) / segment_size_ + 1, nullptr)
+	{
+
+	}
+
+	template<typename T>
+	SegmentedRingBlockingQueue<T>::~SegmentedRingBlockingQueue()
+	{
+		for(std::size_t position = tail_; position != head_; ++position)
+		{
+			std::destroy_at(slot(position));
+		}
+		for(auto& segment: segments_)
+		{
+			if(segment != nullptr)
+			{
+				allocator_.deallocate(segment, segment_size_);
+			}
+		}
+		for(auto& segment: spare_segments_)
+		{
+			allocator_.deallocate(segment, segment_size_);
+		}
+	}
+
+	template<typename T>
+	typename SegmentedRingBlockingQueue<T>::value_type* SegmentedRingBlockingQueue<T>::slot(
+			std::size_t position
+	) const noexcept
+	{
+		return segments_[position / segment_size_ % segments_.size()] + position % segment_size_;
+	}
+
+	template<typename T>
+	typename SegmentedRingBlockingQueue<T>::value_type*& SegmentedRingBlockingQueue<T>::segment_of(
+			std::size_t position
+	) noexcept
+	{
+		return segments_[position / segment_size_ % segments_.size()];
+	}
+
+	template<typename T>
+	typename SegmentedRingBlockingQueue<T>::value_type* SegmentedRingBlockingQueue<T>::acquire_segment()
+	{
+		if(!spare_segments_.empty())
+		{
+			value_type* segment = spare_segments_.back();
+			spare_segments_.pop_back();
+			return segment;
+		}
+
+		value_type* segment = allocator_.allocate(segment_size_);
+		++allocated_segments_;
+		return segment;
+	}
+
+	template<typename T>
+	void SegmentedRingBlockingQueue<T>::release_segment(value_type*& segment) noexcept
+	{
+		try
+		{
+			spare_segments_.push_back(segment);
+		}
+		catch(...)
+		{
+			allocator_.deallocate(segment, segment_size_);
+			--allocated_segments_;
+		}
+		segment = nullptr;
+	}
+
+	template<typename T>
+	void SegmentedRingBlockingQueue<T>::trim_spare_segments() noexcept
+	{
+		// keep a single spare segment for the next wrap-around
+		while(spare_segments_.size() > 1)
+		{
+			allocator_.deallocate(spare_segments_.back(), segment_size_);
+			spare_segments_.pop_back();
+			--allocated_segments_;
+		}
+	}
+
+	template<typename T>
+	template<typename U>
+	void SegmentedRingBlockingQueue<T>::emplace_head(U&& elem)
+	{
+		value_type*& segment = segment_of(head_);
+		if(segment == nullptr)
+		{
+			segment = acquire_segment();
+		}
+
+		// head_ is advanced only after successful construction
+		std::construct_at(segment + head_ % segment_size_, std::forward<U>(elem));
+		++head_;
+		counters_.on_push();
+	}
+
+	template<typename T>
+	void SegmentedRingBlockingQueue<T>::advance_tail() noexcept
+	{
+		std::destroy_at(slot(tail_));
+		++tail_;
+		counters_.on_pop();
+
+		if(tail_ % segment_size_ == 0)
+		{
+			release_segment(segment_of(tail_ - 1));
+		}
+
+		if(head_ - tail_ < segment_size_)
+		{
+			if(++low_occupancy_pops_ >= release_threshold_)
+			{
+				trim_spare_segments();
+				low_occupancy_pops_ = 0;
+			}
+		}
+		else
+		{
+			low_occupancy_pops_ = 0;
+		}
+	}
+
+	template<typename T>
+	void SegmentedRingBlockingQueue<T>::push(const value_type& elem)
+	{
+		if(wait_push(elem) == QueueOpStatus::closed)
+		{
+			throw QueueClosedException();
+		}
+	}
+
+	template<typename T>
+	void SegmentedRingBlockingQueue<T>::push(value_type&& elem)
+	{
+		if(wait_push(std::move(elem)) == QueueOpStatus::closed)
+		{
+			throw QueueClosedException();
+		}
+	}
+
+	template<typename T>
+	QueueOpStatus SegmentedRingBlockingQueue<T>::try_push(const value_type& elem)
+	{
+		return try_push_impl(elem);
+	}
+
+	template<typename T>
+	QueueOpStatus SegmentedRingBlockingQueue<T>::try_push(value_type&& elem)
+	{
+		return try_push_impl(std::move(elem));
+	}
+
+	template<typename T>
+	template<typename U>
+	QueueOpStatus SegmentedRingBlockingQueue<T>::try_push_impl(U&& elem)
+	{
+		{
+			std::scoped_lock lock(queue_mutex_);
+			if(closed_)
+			{
+				return QueueOpStatus::closed;
+			}
+
+			if(head_ - tail_ == capacity_)
+			{
+				return QueueOpStatus::full;
+			}
+
+			emplace_head(std::forward<U>(elem));
+		}
+
+		consumer_cv_.notify_one();
+		return QueueOpStatus::success;
+	}
+
+	template<typename T>
+	QueueOpStatus SegmentedRingBlockingQueue<T>::wait_push(const value_type& elem)
+	{
+		return wait_push_impl(elem);
+	}
+
+	template<typename T>
+	QueueOpStatus SegmentedRingBlockingQueue<T>::wait_push(value_type&& elem)
+	{
+		return wait_push_impl(std::move(elem));
+	}
+
+	template<typename T>
+	template<typename U>
+	QueueOpStatus SegmentedRingBlockingQueue<T>::wait_push_impl(U&& elem)
+	{
+		{
+			std::unique_lock<std::mutex> lock(queue_mutex_);
+
+			while(true)
+			{
+				if(closed_)
+				{
+					return QueueOpStatus::closed;
+				}
+
+				if(head_ - tail_ != capacity_)
+				{
+					break;
+				}
+				producer_cv_.wait(lock);
+			}
+
+			emplace_head(std::forward<U>(elem));
+		}
+
+		consumer_cv_.notify_one();
+		return QueueOpStatus::success;
+	}
+
+	template<typename T>
+	template<typename Rep, typename Period>
+	QueueOpStatus SegmentedRingBlockingQueue<T>::wait_push_for(
+			const value_type& elem,
+			const std::chrono::duration<Rep, Period>& timeout
+	)
+	{
+		return wait_push_until_impl(elem, std::chrono::steady_clock::now() + timeout);
+	}
+
+	template<typename T>
+	template<typename Rep, typename Period>
+	QueueOpStatus SegmentedRingBlockingQueue<T>::wait_push_for(
+			value_type&& elem,
+			const std::chrono::duration<Rep, Period>& timeout
+	)
+	{
+		return wait_push_until_impl(std::move(elem), std::chrono::steady_clock::now() + timeout);
+	}
+
+	template<typename T>
+	template<typename Clock, typename Duration>
+	QueueOpStatus SegmentedRingBlockingQueue<T>::wait_push_until(
+			const value_type& elem,
+			const std::chrono::time_point<Clock, Duration>& deadline
+	)
+	{
+		return wait_push_until_impl(elem, deadline);
+	}
+
+	template<typename T>
+	template<typename Clock, typename Duration>
+	QueueOpStatus SegmentedRingBlockingQueue<T>::wait_push_until(
+			value_type&& elem,
+			const std::chrono::time_point<Clock, Duration>& deadline
+	)
+	{
+		return wait_push_until_impl(std::move(elem), deadline);
+	}
+
+	template<typename T>
+	template<typename U, typename Clock, typename Duration>
+	QueueOpStatus SegmentedRingBlockingQueue<T>::wait_push_until_impl(
+			U&& elem,
+			const std::chrono::time_point<Clock, Duration>& deadline
+	)
+	{
+		{
+			std::unique_lock<std::mutex> lock(queue_mutex_);
+
+			while(true)
+			{
+				if(closed_)
+				{
+					return QueueOpStatus::closed;
+				}
+
+				if(head_ - tail_ != capacity_)
+				{
+					break;
+				}
+
+				if(Clock::now() >= deadline)
+				{
+					return QueueOpStatus::timeout;
+				}
+				producer_cv_.wait_until(lock, deadline);
+			}
+
+			emplace_head(std::forward<U>(elem));
+		}
+
+		consumer_cv_.notify_one();
+		return QueueOpStatus::success;
+	}
+
+	template<typename T>
+	typename SegmentedRingBlockingQueue<T>::value_type SegmentedRingBlockingQueue<T>::value_pop()
+	{
+		std::unique_lock<std::mutex> lock(queue_mutex_);
+
+		while(head_ == tail_)
+		{
+			if(closed_)
+			{
+				throw QueueClosedException();
+			}
+			consumer_cv_.wait(lock);
+		}
+
+		value_type elem(std::move(*slot(tail_)));
+		advance_tail();
+
+		lock.unlock();
+		producer_cv_.notify_one();
+
+		return elem;
+	}
+
+	template<typename T>
+	QueueOpStatus SegmentedRingBlockingQueue<T>::try_pop(value_type& dest)
+	{
+		{
+			std::lock_guard<std::mutex> lock(queue_mutex_);
+
+			if(head_ == tail_)
+			{
+				if(closed_)
+				{
+					return QueueOpStatus::closed;
+				}
+				else
+				{
+					return QueueOpStatus::empty;
+				}
+			}
+
+			dest = std::move(*slot(tail_));
+			advance_tail();
+		}
+
+		producer_cv_.notify_one();
+		return QueueOpStatus::success;
+	}
+
+	template<typename T>
+	QueueOpStatus SegmentedRingBlockingQueue<T>::wait_pop(value_type& dest)
+	{
+		{
+			std::unique_lock<std::mutex> lock(queue_mutex_);
+
+			while(head_ == tail_)
+			{
+				if(closed_)
+				{
+					return QueueOpStatus::closed;
+				}
+				consumer_cv_.wait(lock);
+			}
+
+			dest = std::move(*slot(tail_));
+			advance_tail();
+		}
+
+		producer_cv_.notify_one();
+		return QueueOpStatus::success;
+	}
+
+	template<typename T>
+	template<typename Rep, typename Period>
+	QueueOpStatus SegmentedRingBlockingQueue<T>::wait_pop_for(value_type& dest, const std::chrono::duration<Rep, Period>& timeout)
+	{
+		return wait_pop_until(dest, std::chrono::steady_clock::now() + timeout);
+	}
+
+	template<typename T>
+	template<typename Clock, typename Duration>
+	QueueOpStatus SegmentedRingBlockingQueue<T>::wait_pop_until(
+			value_type& dest,
+			const std::chrono::time_point<Clock, Duration>& deadline
+	)
+	{
+		{
+			std::unique_lock<std::mutex> lock(queue_mutex_);
+
+			while(head_ == tail_)
+			{
+				if(closed_)
+				{
+					return QueueOpStatus::closed;
+				}
+
+				if(Clock::now() >= deadline)
+				{
+					return QueueOpStatus::timeout;
+				}
+				consumer_cv_.wait_until(lock, deadline);
+			}
+
+			dest = std::move(*slot(tail_));
+			advance_tail();
+		}
+
+		producer_cv_.notify_one();
+		return QueueOpStatus::success;
+	}
+
+	template<typename T>
+	void SegmentedRingBlockingQueue<T>::close() noexcept
+	{
+		{
+			std::scoped_lock queue_lock(queue_mutex_);
+			closed_ = true;
+			counters_.on_close();
+		}
+
+		consumer_cv_.notify_all();
+		producer_cv_.notify_all();
+	}
+
+	template<typename T>
+	bool SegmentedRingBlockingQueue<T>::closed() const noexcept
+	{
+		std::scoped_lock queue_lock(queue_mutex_);
+		return closed_;
+	}
+
+	template<typename T>
+	bool SegmentedRingBlockingQueue<T>::empty() const noexcept
+	{
+		std::scoped_lock queue_lock(queue_mutex_);
+		return head_ == tail_;
+	}
+
+	template<typename T>
+	bool SegmentedRingBlockingQueue<T>::full() const noexcept
+	{
+		std::scoped_lock queue_lock(queue_mutex_);
+		return head_ - tail_ == capacity_;
+	}
+
+	template<typename T>
+	std::size_t SegmentedRingBlockingQueue<T>::size() const noexcept
+	{
+		std::scoped_lock queue_lock(queue_mutex_);
+		return head_ - tail_;
+	}
+
+	template<typename T>
+	std::size_t SegmentedRingBlockingQueue<T>::capacity() const noexcept
+	{
+		return capacity_;
+	}
+
+	template<typename T>
+	std::size_t SegmentedRingBlockingQueue<T>::segment_size() const noexcept
+	{
+		return segment_size_;
+	}
+
+	template<typename T>
+	std::size_t SegmentedRingBlockingQueue<T>::allocated_segments() const noexcept
+	{
+		std::scoped_lock queue_lock(queue_mutex_);
+		return allocated_segments_;
+	}
+
+	template<typename T>
+	size_t SegmentedRingBlockingQueue<T>::check_size(size_t size)
+	{
+		if(size == 0)
+		{
+			throw std::invalid_argument("Cannot create SegmentedRingBlockingQueue of size 0");
+		}
+		return size;
+	}
+
+	template<typename T>
+	void SegmentedRingBlockingQueue<T>::reserve(std::size_t count)
+	{
+		std::scoped_lock queue_lock(queue_mutex_);
+
+		const std::size_t wanted = (std::min(count, capacity_) + segment_size_ - 1) / segment_size_;
+		while(allocated_segments_ < wanted)
+		{
+			value_type* segment = allocator_.allocate(segment_size_);
+			detail::prefault(segment, segment_size_ * sizeof(value_type));
+			try
+			{
+				spare_segments_.push_back(segment);
+			}
+			catch(...)
+			{
+				allocator_.deallocate(segment, segment_size_);
+				throw;
+			}
+			++allocated_segments_;
+		}
+	}
+
+	template<typename T>
+	QueueStats SegmentedRingBlockingQueue<T>::stats() const noexcept
+	{
+		return counters_.snapshot();
+	}
+}
+
+#endif //THREAD_POOL_SEGMENTED_RING_BLOCKING_QUEUE_HPP
@@ -0,0 +1,279 @@
+#ifndef THREAD_POOL_STRAND_HPP
+#define THREAD_POOL_STRAND_HPP
+
+#include "detail/_bound_task.hpp"
+#include "policy.hpp"
+
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <future>
+#include <memory>
+#include <thread>
+#include <utility>
+
+
+namespace thread_pool
+{
+	/**
+	 * Serial executor running its tasks one at a time, in FIFO order, on workers of a shared pool.
+	 *
+	 * Tasks are kept in a lock-free intrusive MPSC list. The first task posted to an idle strand
+	 * schedules a drain task on the pool, which runs up to max_batch tasks before rescheduling itself,
+	 * so a busy strand does not monopolize a worker. An idle strand owns no thread and holds only
+	 * a handful of words. A pool with try_post() gets the rescheduled drain without blocking; if the
+	 * pool does not take it (full or closed queue), the drain simply goes on on the same worker. Tasks
+	 * posted while the pool refuses any work run on the posting thread.
+	 *
+	 * Tasks still pending when the strand is destroyed are run. The pool has to outlive them.
+	 */
+	template<typename Pool>
+	class Strand
+	{
+	public:
+		static constexpr std::size_t max_batch = 64;
+
+		explicit Strand(Pool& pool);
+
+		Strand(const Strand&) = delete;
+		Strand& operator=(const Strand&) = delete;
+
+		/**
+		 * Callable and arguments are decay-copied into the task like by ThreadPool::enqueue.
+		 */
+		template<typename F, typename... Args>
+		requires std::invocable<std::decay_t<F>, std::decay_t<Args>...>
+		auto enqueue(F&& fun, Args&&... args) -> std::future<detail::task_result_t<F, Args...>>;
+
+		/**
+		 * Fire-and-forget variant of enqueue, an exception escaping fun terminates the program.
+		 */
+		template<typename F>
+		requires std::invocable<std::decay_t<F>&>
+		void post(F&& fun);
+
+	private:
+		struct Node
+		{
+			std::atomic<Node*> next = nullptr;
+
+			virtual void invoke() {}
+			virtual ~Node() = default;
+		};
+
+		template<typename F>
+		struct TaskNode: Node
+		{
+			template<typename... CtorArgs>
+			explicit TaskNode(std::in_place_t, CtorArgs&&... ctor_args)
+			:
+				fun_(std::forward<CtorArgs>(ctor_args)...)
+			{}
+
+			void invoke() final
+			{
+				fun_();
+			}
+
+			F fun_;
+		};
+
+		struct State
+		{
+			explicit State(Pool& pool)
+			:
+				pool(pool)
+			{}
+
+			~State()
+			{
+				// drained before destruction, only the stub may be left
+				while(Node* node = pop())
+				{
+					delete node;
+				}
+			}
+
+			Pool& pool;
+			std::atomic<std::size_t> pending = 0;
+			std::atomic<Node*> head = &stub;
+			Node* tail = &stub;
+			Node stub;
+
+			void push(Node* node) noexcept;
+			Node* pop() noexcept;
+		};
+
+		std::shared_ptr<State> state_;
+
+		void push(Node* node);
+
+		static void schedule(std::shared_ptr<State> state);
+		static bool try_schedule(const std::shared_ptr<State>& state) noexcept;
+		static void drain(const std::shared_ptr<State>& state) noexcept;
+	};
+
+	template<typename Pool>
+	Strand<Pool>::Strand(Pool& pool)
+	:
+		state_(std::make_shared<State>(pool))
+	{}
+
+	template<typename Pool>
+	template<typename F, typename... Args>
+	requires std::invocable<std::decay_t<F>, std::decay_t<Args>...>
+	auto Strand<Pool>::enqueue(F&& fun, Args&&... args) -> std::future<detail::task_result_t<F, Args...>>
+	{
+		return FutureResult::submit<detail::task_result_t<F, Args...>>(
+				[this]<typename T, typename... CtorArgs>(std::in_place_type_t<T>, CtorArgs&&... ctor_args)
+				{
+					push(new TaskNode<T>(std::in_place, std::forward<CtorArgs>(ctor_args)...));
+				},
+				std::forward<F>(fun),
+				std::forward<Args>(args)...
+		);
+	}
+
+	template<typename Pool>
+	template<typename F>
+	requires std::invocable<std::decay_t<F>&>
+	void Strand<Pool>::post(F&& fun)
+	{
+		push(new TaskNode<std::decay_t<F>>(std::in_place, std::forward<F>(fun)));
+	}
+
+	template<typename Pool>
+	void Strand<Pool>::push(Node* node)
+	{
+		state_->push(node);
+		if(state_->pending.fetch_add(1, std::memory_order_acq_rel) == 0)
+		{
+			try
+			{
+				schedule(state_);
+			}
+			catch(...)
+			{
+				// the pool does not take work anymore, this thread owns the drain now
+				drain(state_);
+			}
+		}
+	}
+
+	template<typename Pool>
+	void Strand<Pool>::State::push(Node* node) noexcept
+	{
+		node->next.store(nullptr, std::memory_order_relaxed);
+		Node* previous = head.exchange(node, std::memory_order_acq_rel);
+		previous->next.store(node, std::memory_order_release);
+	}
+
+	template<typename Pool>
+	typename Strand<Pool>::Node* Strand<Pool>::State::pop() noexcept
+	{
+		Node* current = tail;
+		Node* next = current->next.load(std::memory_order_acquire);
+
+		if(current == &stub)
+		{
+			if(next == nullptr)
+			{
+				return nullptr;
+			}
+			tail = next;
+			current = next;
+			next = next->next.load(std::memory_order_acquire);
+		}
+
+		if(next != nullptr)
+		{
+			tail = next;
+			return current;
+		}
+
+		if(current != head.load(std::memory_order_acquire))
+		{
+			// producer is between exchange and linking
+			return nullptr;
+		}
+
+		push(&stub);
+		next = current->next.load(std::memory_order_acquire);
+		if(next != nullptr)
+		{
+			tail = next;
+			return current;
+		}
+		return nullptr;
+	}
+
+	template<typename Pool>
+	void Strand<Pool>::schedule(std::shared_ptr<State> state)
+	{
+		Pool& pool = state->pool;
+		static_cast<void>(
+				pool.enqueue(
+						[state = std::move(state)]()
+						{
+							drain(state);
+						}
+				)
+		);
+	}
+
+	template<typename Pool>
+	bool Strand<Pool>::try_schedule(const std::shared_ptr<State>& state) noexcept
+	{
+		try
+		{
+			Pool& pool = state->pool;
+			if constexpr(requires { { pool.try_post([state](){ drain(state); }) } -> std::convertible_to<bool>; })
+			{
+				return pool.try_post([state](){ drain(state); });
+			}
+			else
+			{
+				schedule(state);
+				return true;
+			}
+		}
+		catch(...)
+		{
+			return false;
+		}
+	}
+
+	template<typename Pool>
+	void Strand<Pool>::drain(const std::shared_ptr<State>& state) noexcept
+	{
+		for(std::size_t executed = 1; ; ++executed)
+		{
+			Node* node;
+			while((node = state->pop()) == nullptr)
+			{
+				// pending counter guarantees a node is being pushed
+				std::this_thread::yield();
+			}
+
+			node->invoke();
+			delete node;
+
+			if(state->pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				return;
+			}
+
+			if(executed == max_batch)
+			{
+				if(try_schedule(state))
+				{
+					return;
+				}
+				// the pool queue is full or closed, keep draining here rather than block or drop the strand
+				executed = 0;
+			}
+		}
+	}
+}
+
+#endif //THREAD_POOL_STRAND_HPP
@@ -2,84 +2,1100 @@
 #define THREAD_POOL_THREAD_POOL_HPP
 
 #include "detail/_queue_requirement.hpp"
+#include "detail/_policy_requirement.hpp"
 #include "detail/_task.hpp"
+#include "detail/_bound_task.hpp"
+#include "detail/_worker_context.hpp"
+#include "detail/_map_reduce.hpp"
+#include "detail/_jump_hash.hpp"
+#include "detail/_latch.hpp"
+#include "cooperative_task.hpp"
 #include "queue/naive_blocking_queue.hpp"
+#include "queue/event_count.hpp"
+#include "policy.hpp"
 
 #include <thread>
 #include <future>
 #include <vector>
+#include <algorithm>
+#include <memory>
+#include <atomic>
+#include <chrono>
 #include <concepts>
 #include <cassert>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <type_traits>
+#include <utility>
 
 
 namespace thread_pool {
-	template<template <typename> class Q = NaiveBlockingQueue>
-			requires detail::task_queue<Q<detail::Task>>
+	/**
+	 * Approximate pool snapshot, gathered without taking any queue lock.
+	 */
+	struct PoolStats
+	{
+		std::size_t thread_count;
+		// workers spawned so far, below thread_count only for a lazily started pool
+		std::size_t started_workers;
+		// regular and compensating workers currently running a task
+		std::size_t active_workers;
+		// regular workers waiting for a task
+		std::size_t idle_workers;
+		std::size_t compensating_workers;
+		std::size_t queued;
+		// highest depth any shard has reached
+		std::size_t queue_high_water_mark;
+		std::vector<QueueStats> shards;
+	};
+
+	/**
+	 * Constructor tag: workers are spawned on demand instead of all at construction.
+	 */
+	struct LazyStart
+	{
+		explicit LazyStart() = default;
+	};
+
+	inline constexpr LazyStart lazy_start{};
+
+	/**
+	 * Pool of worker threads processing tasks from shared queues.
+	 *
+	 * Tasks are distributed over shard_count queues of type Q (round-robin on submission).
+	 * Each worker has a home shard: it checks it first, then scans the other shards
+	 * and parks on its home shard (through Policy::wait_strategy) only when all of them are empty.
+	 *
+	 * Task storage, wait strategy, result reporting, metrics, thread creation, per-worker state
+	 * and context propagation are selected at compile time by Policy (see DefaultPolicy).
+	 *
+	 * Tasks which block (I/O, legacy locks) announce it with blocking_section() or are submitted
+	 * through enqueue_blocking(). For every blocked worker the pool starts a compensating worker
+	 * (up to max_compensating_threads()), which retires once it is no longer needed.
+	 *
+	 * A pool constructed with lazy_start spawns no thread up front. A submission spawns a worker
+	 * when none is parked, and a worker picking up a task spawns the next one while work is still
+	 * queued, until thread_count workers run.
+	 */
+	template<template <typename> class Q = NaiveBlockingQueue, typename Policy = DefaultPolicy>
+			requires detail::pool_policy<Policy> && detail::task_queue<Q<typename Policy::task_type>>
 	class ThreadPool
 	{
 	public:
+		using task_type = typename Policy::task_type;
+		using queue_type = Q<task_type>;
+		using wait_strategy = typename Policy::wait_strategy;
+		using result_policy = typename Policy::result_policy;
+		using metrics_type = typename Policy::metrics;
+		using thread_factory_type = typename Policy::thread_factory;
+		using thread_type = typename thread_factory_type::thread_type;
+		using worker_state = typename Policy::worker_state;
+		using context_type = typename Policy::context;
+
+		static constexpr std::chrono::milliseconds compensation_poll_interval{10};
+
+		class BlockingSection
+		{
+		public:
+			explicit BlockingSection(ThreadPool* pool)
+			:
+				pool_(pool)
+			{
+				if(pool_ != nullptr)
+				{
+					pool_->begin_blocking();
+				}
+			}
+
+			~BlockingSection()
+			{
+				if(pool_ != nullptr)
+				{
+					pool_->end_blocking();
+				}
+			}
+
+			BlockingSection(const BlockingSection&) = delete;
+			BlockingSection& operator=(const BlockingSection&) = delete;
+
+		private:
+			ThreadPool* pool_;
+		};
+
 		explicit ThreadPool(std::size_t thread_count=std::thread::hardware_concurrency())
+		:
+			ThreadPool(thread_count, 1)
+		{}
+
+		template<typename... QueueArgs>
+		requires std::constructible_from<queue_type, QueueArgs&...>
+		ThreadPool(std::size_t thread_count, std::size_t shard_count, QueueArgs&&... queue_args)
+		:
+			ThreadPool(thread_factory_type{}, thread_count, shard_count, std::forward<QueueArgs>(queue_args)...)
+		{}
+
+		template<typename... QueueArgs>
+		requires std::constructible_from<queue_type, QueueArgs&...>
+		ThreadPool(
+				thread_factory_type thread_factory,
+				std::size_t thread_count,
+				std::size_t shard_count,
+				QueueArgs&&... queue_args
+		)
+		:
+			ThreadPool(StartMode::eager, std::move(thread_factory), thread_count, shard_count, std::forward<QueueArgs>(queue_args)...)
+		{}
+
+		explicit ThreadPool(LazyStart, std::size_t thread_count=std::thread::hardware_concurrency())
+		:
+			ThreadPool(lazy_start, thread_count, 1)
+		{}
+
+		template<typename... QueueArgs>
+		requires std::constructible_from<queue_type, QueueArgs&...>
+		ThreadPool(LazyStart, std::size_t thread_count, std::size_t shard_count, QueueArgs&&... queue_args)
+		:
+			ThreadPool(StartMode::lazy, thread_factory_type{}, thread_count, shard_count, std::forward<QueueArgs>(queue_args)...)
+		{}
+
+		template<typename... QueueArgs>
+		requires std::constructible_from<queue_type, QueueArgs&...>
+		ThreadPool(
+				LazyStart,
+				thread_factory_type thread_factory,
+				std::size_t thread_count,
+				std::size_t shard_count,
+				QueueArgs&&... queue_args
+		)
+		:
+			ThreadPool(StartMode::lazy, std::move(thread_factory), thread_count, shard_count, std::forward<QueueArgs>(queue_args)...)
+		{}
+
+	private:
+		enum class StartMode
+		{
+			eager,
+			lazy
+		};
+
+		template<typename... QueueArgs>
+		ThreadPool(
+				StartMode mode,
+				thread_factory_type thread_factory,
+				std::size_t thread_count,
+				std::size_t shard_count,
+				QueueArgs&&... queue_args
+		)
+		:
+			thread_factory_(std::move(thread_factory)),
+			worker_count_(thread_count),
+			max_compensating_(thread_count)
 		{
 			assert(thread_count != 0);
+			assert(shard_count != 0);
 
-			for(std::size_t i = 0; i < thread_count; ++i)
+			shard_count = std::min(shard_count, thread_count);
+			shards_.reserve(shard_count);
+			for(std::size_t i = 0; i < shard_count; ++i)
 			{
-				workers_.emplace_back
-				(
-					[&]()
-					{
-						detail::Task work;
-						while(true)
-						{
-							auto state = tasks_.wait_pop(work);
-							if(state == QueueOpStatus::closed)
-							{
-								return;
-							}
-							work();
-						}
-					}
-				);
+				shards_.emplace_back(std::make_unique<queue_type>(queue_args...));
+			}
+
+			activity_ = std::make_unique<WorkerActivity[]>(thread_count);
+			shard_activity_ = std::make_unique<ShardActivity[]>(shard_count);
+			workers_.reserve(thread_count);
+
+			if(mode == StartMode::lazy)
+			{
+				return;
+			}
+
+			detail::Latch workers_started(static_cast<std::ptrdiff_t>(thread_count));
+			{
+				std::scoped_lock lock(spawn_mutex_);
+				for(std::size_t i = 0; i < thread_count; ++i)
+				{
+					start_worker_locked(&workers_started);
+				}
 			}
+
+			// all worker states are constructed before the pool accepts work
+			workers_started.wait();
 		}
 
+	public:
+
 		~ThreadPool()
 		{
-			tasks_.close();
+			{
+				std::scoped_lock lock(compensation_mutex_);
+				stopping_ = true;
+			}
+			{
+				std::scoped_lock lock(spawn_mutex_);
+				spawn_closed_ = true;
+			}
+
+			for(auto& shard: shards_)
+			{
+				shard->close();
+			}
+			closing_.store(true);
+			idle_.notify_all();
 			for(auto& worker: workers_)
 			{
 				worker.join();
 			}
+
+			// no compensating worker can be started anymore
+			for(auto& compensator: compensators_)
+			{
+				compensator->thread.join();
+			}
+		}
+
+		/**
+		 * Enqueues fun(args...). Callable and arguments are decay-copied (moved when passed as rvalues)
+		 * once into the task storage and invoked through std::invoke, like std::async does.
+		 */
+		template<typename F, typename... Args>
+		requires std::invocable<std::decay_t<F>, std::decay_t<Args>...>
+		auto enqueue(F&& fun, Args&&... args)
+		{
+			return enqueue(TaskLabel(), std::forward<F>(fun), std::forward<Args>(args)...);
+		}
+
+		/**
+		 * Enqueues task with a label reported to the metrics hook.
+		 */
+		template<typename F, typename... Args>
+		requires std::invocable<std::decay_t<F>, std::decay_t<Args>...>
+		auto enqueue(TaskLabel label, F&& fun, Args&&... args)
+		{
+			return result_policy::template submit<detail::task_result_t<F, Args...>>(
+					[this, label]<typename T, typename... CtorArgs>(std::in_place_type_t<T>, CtorArgs&&... ctor_args)
+					{
+						emplace_task<T>(next_shard(), label, std::forward<CtorArgs>(ctor_args)...);
+					},
+					std::forward<F>(fun),
+					std::forward<Args>(args)...
+			);
+		}
+
+		/**
+		 * Enqueues fun(args...) to the shard preferred by key, so tasks with equal keys share
+		 * a worker and its cache when shard_count() equals thread_count(). While the worker of that
+		 * shard is busy, an idle worker is woken and takes them over.
+		 *
+		 * Keys are mapped with std::hash and jump consistent hashing, so changing the shard count
+		 * only moves the keys of the added or removed shards.
+		 */
+		template<typename Key, typename F, typename... Args>
+		requires std::invocable<std::decay_t<F>, std::decay_t<Args>...>
+				&& requires(const Key& key) { { std::hash<Key>{}(key) } -> std::convertible_to<std::size_t>; }
+		auto enqueue_keyed(const Key& key, F&& fun, Args&&... args)
+		{
+			return result_policy::template submit<detail::task_result_t<F, Args...>>(
+					[this, shard = shard_for(key)]<typename T, typename... CtorArgs>(std::in_place_type_t<T>, CtorArgs&&... ctor_args)
+					{
+						emplace_task<T>(shard, TaskLabel(), std::forward<CtorArgs>(ctor_args)...);
+					},
+					std::forward<F>(fun),
+					std::forward<Args>(args)...
+			);
+		}
+
+		/**
+		 * Shard used by enqueue_keyed for key.
+		 */
+		template<typename Key>
+		[[nodiscard]] std::size_t shard_for(const Key& key) const noexcept(noexcept(std::hash<Key>{}(key)))
+		{
+			return detail::jump_hash(static_cast<std::uint64_t>(std::hash<Key>{}(key)), shards_.size());
+		}
+
+#ifdef THREAD_POOL_COOPERATIVE_TASKS
+		/**
+		 * Enqueues the cooperative task returned by fun(args...), see CooperativeTask. Only available with
+		 * compiler coroutine support (THREAD_POOL_COOPERATIVE_TASKS is defined).
+		 *
+		 * Callable and arguments are decay-copied and kept alive with the coroutine frame, so a capturing
+		 * lambda coroutine is safe. A yield re-enqueues the frame itself to the next shard; with metrics or
+		 * context enabled every slice is wrapped (and reported) like a separate task. A yield which finds
+		 * the queue full or closed continues running instead.
+		 */
+		template<typename F, typename... Args>
+		requires std::same_as<task_type, detail::Task>
+				&& std::invocable<std::decay_t<F>&, std::decay_t<Args>&...>
+				&& detail::is_cooperative_task<std::invoke_result_t<std::decay_t<F>&, std::decay_t<Args>&...>>::value
+		auto enqueue_cooperative(F&& fun, Args&&... args)
+		{
+			using call_type = detail::CooperativeCall<std::decay_t<F>, std::decay_t<Args>...>;
+			using value_type = typename std::invoke_result_t<std::decay_t<F>&, std::decay_t<Args>&...>::value_type;
+
+			auto call = std::make_shared<call_type>(std::forward<F>(fun), std::forward<Args>(args)...);
+			auto cooperative = call->call();
+
+			auto* promise = cooperative.detach();
+			std::future<value_type> result = promise->get_future();
+			promise->bind(this, &ThreadPool::reschedule_cooperative, std::move(call));
+
+			schedule_cooperative(*promise, false);
+			return result;
+		}
+#endif
+
+		/**
+		 * Enqueues fun() unless that would block: returns false if the queue of the chosen shard is full
+		 * or closed, fun is destroyed then. Nothing is reported for the task, an exception escaping it
+		 * terminates the program.
+		 */
+		template<typename F>
+		requires std::invocable<std::decay_t<F>&>
+		bool try_post(F&& fun)
+		{
+			auto task = task_type(with_metrics(TaskLabel(), with_context(std::forward<F>(fun))));
+			const std::size_t shard = next_shard();
+			if(shards_[shard]->try_push(std::move(task)) != QueueOpStatus::success)
+			{
+				return false;
+			}
+
+			task_pushed(shard);
+			return true;
 		}
 
+		/**
+		 * Enqueues task which is dropped instead of being run if no worker picked it up before deadline.
+		 * Future of a dropped task reports std::future_errc::broken_promise.
+		 */
+		template<typename Clock, typename Duration, typename F, typename... Args>
+		requires std::invocable<std::decay_t<F>, std::decay_t<Args>...>
+		auto enqueue_until(const std::chrono::time_point<Clock, Duration>& deadline, F&& fun, Args&&... args)
+		{
+			return result_policy::template submit<detail::task_result_t<F, Args...>>(
+					[this, &deadline]<typename T, typename... CtorArgs>(std::in_place_type_t<T>, CtorArgs&&... ctor_args)
+					{
+						push_task(
+								TaskLabel(),
+								[deadline, work = T(std::forward<CtorArgs>(ctor_args)...)]() mutable
+								{
+									if(Clock::now() <= deadline)
+									{
+										work();
+									}
+								}
+						);
+					},
+					std::forward<F>(fun),
+					std::forward<Args>(args)...
+			);
+		}
+
+		/**
+		 * Like enqueue, but the task runs inside a blocking_section().
+		 */
 		template<typename F, typename... Args>
-		requires std::invocable<F, Args...>
-		auto enqueue(F fun, Args&&... args) -> std::future<std::invoke_result_t<F, Args...>>
+		requires std::invocable<std::decay_t<F>, std::decay_t<Args>...>
+		auto enqueue_blocking(F&& fun, Args&&... args)
+		{
+			using call_type = detail::BoundCall<std::decay_t<F>, std::decay_t<Args>...>;
+
+			return enqueue(
+					[this, call = call_type(std::forward<F>(fun), std::forward<Args>(args)...)]() mutable
+							-> detail::task_result_t<F, Args...>
+					{
+						auto section = blocking_section();
+						return call();
+					}
+			);
+		}
+
+		/**
+		 * Computes combine(...combine(init, map(0))..., map(count - 1)) in parallel.
+		 *
+		 * Indices are split into chunks of grain (0 picks about four chunks per worker). Each worker
+		 * folds the chunks it runs into its own accumulator, the accumulators are merged into init when
+		 * the last chunk finishes, so the job has a single future. combine has to be associative and
+		 * commutative; an exception from map or combine is reported through the future.
+		 */
+		template<typename T, typename Map, typename Combine>
+		requires std::invocable<Map&, std::size_t>
+				&& std::constructible_from<T, std::invoke_result_t<Map&, std::size_t>>
+				&& std::convertible_to<std::invoke_result_t<Combine&, T, std::invoke_result_t<Map&, std::size_t>>, T>
+				&& std::convertible_to<std::invoke_result_t<Combine&, T, T>, T>
+		std::future<T> map_reduce(std::size_t count, T init, Map map, Combine combine, std::size_t grain = 0)
+		{
+			if(grain == 0)
+			{
+				const std::size_t target_chunks = 4 * worker_count_;
+				grain = std::max<std::size_t>((count + target_chunks - 1) / target_chunks, 1);
+			}
+			// an empty job still has one (empty) chunk completing it
+			const std::size_t chunks = std::max<std::size_t>((count + grain - 1) / grain, 1);
+
+			using job_type = detail::MapReduceJob<T, Map, Combine>;
+			auto job = std::make_shared<job_type>(worker_count_, chunks, std::move(init), std::move(map), std::move(combine));
+			auto result = job->get_future();
+
+			if(count == 0)
+			{
+				job->run_chunk(worker_count_, 0, 0);
+				return result;
+			}
+
+			for(std::size_t begin = 0; begin < count; begin += grain)
+			{
+				push_task(
+						TaskLabel("map_reduce"),
+						[this, job, begin, end = std::min(begin + grain, count)]()
+						{
+							const bool own_worker = detail::this_worker.pool == this;
+							job->run_chunk(own_worker ? detail::this_worker.index : worker_count_, begin, end);
+						}
+				);
+			}
+			return result;
+		}
+
+		/**
+		 * Marks the calling worker as blocked until the returned section is destroyed.
+		 * Has no effect when not called from a worker of this pool.
+		 */
+		[[nodiscard]] BlockingSection blocking_section()
+		{
+			return BlockingSection(detail::this_worker.pool == this ? this : nullptr);
+		}
+
+		void set_max_compensating_threads(std::size_t max_threads)
+		{
+			std::scoped_lock lock(compensation_mutex_);
+			max_compensating_ = max_threads;
+		}
+
+		[[nodiscard]] std::size_t max_compensating_threads() const
 		{
-			auto task = std::packaged_task<std::invoke_result_t<F, Args...>()>
-					(
-							[f = std::move(fun), ...f_args = std::forward<Args>(args)]() mutable
-							{
-								return f(std::forward<Args>(f_args)...);
-							}
-					);
+			std::scoped_lock lock(compensation_mutex_);
+			return max_compensating_;
+		}
 
-			auto task_future = task.get_future();
-			tasks_.push([worker_task = std::move(task)]() mutable { worker_task(); });
+		/**
+		 * Number of compensating workers currently running.
+		 */
+		[[nodiscard]] std::size_t compensating_thread_count() const noexcept
+		{
+			return active_compensators_.load(std::memory_order_relaxed);
+		}
 
-			return task_future;
+		/**
+		 * Worker activity and per-shard queue statistics, cheap enough to poll from a monitor.
+		 * Shards whose queue has no stats() report its size() and closed() instead.
+		 */
+		[[nodiscard]] PoolStats stats() const
+		{
+			PoolStats result{};
+			result.thread_count = worker_count_;
+			result.started_workers = started_thread_count();
+			result.compensating_workers = compensating_thread_count();
+
+			std::size_t busy = 0;
+			for(std::size_t i = 0; i < worker_count_; ++i)
+			{
+				busy += activity_[i].busy.load(std::memory_order_relaxed) ? 1 : 0;
+			}
+			// a worker spawned after started_workers was read may already be busy
+			busy = std::min(busy, result.started_workers);
+			result.active_workers = busy + busy_compensators_.load(std::memory_order_relaxed);
+			result.idle_workers = result.started_workers - busy;
+
+			result.shards.reserve(shards_.size());
+			for(const auto& shard: shards_)
+			{
+				const QueueStats shard_stats = queue_stats(*shard);
+				result.queued += shard_stats.size;
+				result.queue_high_water_mark = std::max(result.queue_high_water_mark, shard_stats.high_water_mark);
+				result.shards.push_back(shard_stats);
+			}
+			return result;
 		}
 
 		[[nodiscard]] std::size_t thread_count() const noexcept
 		{
-			return workers_.size();
+			return worker_count_;
+		}
+
+		/**
+		 * Number of regular workers spawned so far, equal to thread_count() unless the pool starts lazily.
+		 */
+		[[nodiscard]] std::size_t started_thread_count() const noexcept
+		{
+			return started_workers_.load(std::memory_order_acquire);
+		}
+
+		/**
+		 * Preallocates and prefaults queue storage for about count pending tasks spread over the shards,
+		 * so the first burst of submissions does not page fault. Queues without reserve() are left as they are.
+		 */
+		void reserve(std::size_t count)
+		{
+			const std::size_t per_shard = (count + shards_.size() - 1) / shards_.size();
+			for(auto& shard: shards_)
+			{
+				if constexpr(requires { shard->reserve(per_shard); })
+				{
+					shard->reserve(per_shard);
+				}
+			}
+		}
+
+		[[nodiscard]] std::size_t shard_count() const noexcept
+		{
+			return shards_.size();
+		}
+
+		/**
+		 * State of the worker running the calling thread, nullptr if it is not a worker of a pool of this type.
+		 */
+		[[nodiscard]] static worker_state* current_worker() noexcept
+		{
+			if(detail::this_worker.pool_type != &type_tag_)
+			{
+				return nullptr;
+			}
+			return static_cast<worker_state*>(detail::this_worker.state);
+		}
+
+		[[nodiscard]] metrics_type& metrics() noexcept
+		{
+			return metrics_;
+		}
+
+		[[nodiscard]] const metrics_type& metrics() const noexcept
+		{
+			return metrics_;
 		}
 
 	private:
-		std::vector<std::thread> workers_;
+		static constexpr char type_tag_ = 0;
+
+		std::vector<std::unique_ptr<queue_type>> shards_;
+		std::atomic<std::size_t> next_shard_ = 0;
+
+		[[no_unique_address]] metrics_type metrics_;
+		[[no_unique_address]] thread_factory_type thread_factory_;
+
+		std::size_t worker_count_;
+		// workers_ only grows (up to worker_count_ reserved slots) under spawn_mutex_
+		std::mutex spawn_mutex_;
+		std::vector<thread_type> workers_;
+		std::atomic<std::size_t> started_workers_ = 0;
+		bool spawn_closed_ = false;
+
+		// workers parked on the shard, a lazy pool spawns when a submission finds none on its shard
+		struct alignas(64) ShardActivity
+		{
+			std::atomic<std::size_t> parked = 0;
+		};
+
+		std::unique_ptr<ShardActivity[]> shard_activity_;
+		// idle workers of a sharded pool wait here, woken by every push and by the destructor
+		EventCount idle_;
+		std::atomic<bool> closing_ = false;
+
+		struct alignas(64) WorkerActivity
+		{
+			std::atomic<bool> busy = false;
+		};
+
+		std::unique_ptr<WorkerActivity[]> activity_;
+		std::atomic<std::size_t> busy_compensators_ = 0;
+
+		struct Compensator
+		{
+			std::size_t slot;
+			std::atomic<bool> finished = false;
+			thread_type thread;
+		};
+
+		mutable std::mutex compensation_mutex_;
+		std::vector<std::unique_ptr<Compensator>> compensators_;
+		std::size_t max_compensating_;
+		// modified under compensation_mutex_, atomic for stats()
+		std::atomic<std::size_t> active_compensators_ = 0;
+		std::size_t blocked_ = 0;
+		bool stopping_ = false;
+
+		template<typename T, typename... CtorArgs>
+		void emplace_task(std::size_t shard, TaskLabel label, CtorArgs&&... ctor_args)
+		{
+			constexpr bool wrapped = metrics_type::enabled || context_type::enabled;
+			if constexpr(!wrapped && std::constructible_from<task_type, std::in_place_type_t<T>, CtorArgs...>)
+			{
+				shards_[shard]->push(task_type(std::in_place_type<T>, std::forward<CtorArgs>(ctor_args)...));
+				task_pushed(shard);
+			}
+			else
+			{
+				push_task(shard, label, T(std::forward<CtorArgs>(ctor_args)...));
+			}
+		}
+
+		template<typename F>
+		void push_task(TaskLabel label, F&& task)
+		{
+			push_task(next_shard(), label, std::forward<F>(task));
+		}
+
+		template<typename F>
+		void push_task(std::size_t shard, TaskLabel label, F&& task)
+		{
+			shards_[shard]->push(task_type(with_metrics(label, with_context(std::forward<F>(task)))));
+			task_pushed(shard);
+		}
 
-		Q<detail::Task> tasks_;
+#ifdef THREAD_POOL_COOPERATIVE_TASKS
+		// returns false if a try (used by a yield) found the queue full or closed
+		bool schedule_cooperative(detail::CooperativePromiseBase& promise, bool try_only)
+		{
+			task_type task = task_type::adopt(&promise);
+			if constexpr(metrics_type::enabled || context_type::enabled)
+			{
+				task = task_type(with_metrics(TaskLabel(), with_context([slice = std::move(task)]() mutable { slice(); })));
+			}
+
+			const std::size_t shard = next_shard();
+			if(!try_only)
+			{
+				shards_[shard]->push(std::move(task));
+			}
+			else if(shards_[shard]->try_push(std::move(task)) != QueueOpStatus::success)
+			{
+				// the unqueued task releases the reference taken for it
+				return false;
+			}
+
+			task_pushed(shard);
+			return true;
+		}
+
+		static bool reschedule_cooperative(void* pool, detail::CooperativePromiseBase& promise) noexcept
+		{
+			promise.add_reference();
+			try
+			{
+				return static_cast<ThreadPool*>(pool)->schedule_cooperative(promise, true);
+			}
+			catch(...)
+			{
+				return false;
+			}
+		}
+#endif
+
+		// called after every push, an idle worker of a sharded pool scans all shards when woken
+		void task_pushed(std::size_t shard)
+		{
+			if(shards_.size() > 1)
+			{
+				idle_.notify_one();
+			}
+			spawn_for_submission(shard);
+		}
+
+		// a lazy pool grows until every shard a task lands on has a worker of its own parked
+		void spawn_for_submission(std::size_t shard)
+		{
+			const std::size_t started = started_workers_.load(std::memory_order_acquire);
+			if(started == worker_count_)
+			{
+				return;
+			}
+			if(started == 0 || shard_activity_[shard].parked.load(std::memory_order_relaxed) == 0)
+			{
+				spawn_worker();
+			}
+		}
+
+		// called by a worker about to run a task, keeps spawning while the backlog lasts
+		void spawn_for_backlog()
+		{
+			if(started_workers_.load(std::memory_order_acquire) == worker_count_)
+			{
+				return;
+			}
+			if(std::any_of(shards_.begin(), shards_.end(), [](const auto& shard){ return !shard->empty(); }))
+			{
+				spawn_worker();
+			}
+		}
+
+		void spawn_worker()
+		{
+			std::scoped_lock lock(spawn_mutex_);
+			if(!spawn_closed_ && workers_.size() < worker_count_)
+			{
+				start_worker_locked(nullptr);
+			}
+		}
+
+		void start_worker_locked(detail::Latch* workers_started)
+		{
+			const std::size_t index = workers_.size();
+			workers_.emplace_back
+			(
+				thread_factory_.create(
+						index,
+						[this, index, home_shard = index % shards_.size(), workers_started]()
+						{
+							worker_main(index, home_shard, workers_started);
+						}
+				)
+			);
+			started_workers_.store(workers_.size(), std::memory_order_release);
+		}
+
+		template<typename F>
+		static decltype(auto) with_context(F&& task)
+		{
+			if constexpr(context_type::enabled)
+			{
+				return [context = context_type::capture(), work = std::forward<F>(task)]() mutable
+				{
+					typename context_type::scope context_scope(std::move(context));
+					work();
+				};
+			}
+			else
+			{
+				return std::forward<F>(task);
+			}
+		}
+
+		// task with its metrics token, reported through the optional on_discard if destroyed before it ran
+		template<typename F>
+		class MeteredTask
+		{
+		public:
+			template<typename FF>
+			MeteredTask(ThreadPool& pool, TaskLabel label, FF&& work)
+			:
+				pool_(&pool),
+				token_(pool.metrics_.on_enqueue(label)),
+				work_(std::forward<FF>(work))
+			{}
+
+			MeteredTask(MeteredTask&& other)
+			:
+				pool_(std::exchange(other.pool_, nullptr)),
+				token_(std::move(other.token_)),
+				work_(std::move(other.work_))
+			{}
+
+			MeteredTask& operator=(MeteredTask&&) = delete;
+
+			~MeteredTask()
+			{
+				if constexpr(requires(metrics_type& metrics, typename metrics_type::task_token& token) { metrics.on_discard(token); })
+				{
+					if(pool_ != nullptr)
+					{
+						pool_->metrics_.on_discard(token_);
+					}
+				}
+			}
+
+			void operator()()
+			{
+				ThreadPool& pool = *std::exchange(pool_, nullptr);
+				const std::size_t worker = detail::this_worker.index;
+				pool.metrics_.on_task_start(token_, worker);
+				work_();
+				pool.metrics_.on_task_end(token_, worker);
+			}
+
+		private:
+			ThreadPool* pool_;
+			typename metrics_type::task_token token_;
+			F work_;
+		};
+
+		template<typename F>
+		decltype(auto) with_metrics(TaskLabel label, F&& task)
+		{
+			if constexpr(metrics_type::enabled)
+			{
+				return MeteredTask<std::decay_t<F>>(*this, label, std::forward<F>(task));
+			}
+			else
+			{
+				static_cast<void>(label);
+				return std::forward<F>(task);
+			}
+		}
+
+		std::size_t next_shard() noexcept
+		{
+			if(shards_.size() == 1)
+			{
+				return 0;
+			}
+			return next_shard_.fetch_add(1, std::memory_order_relaxed) % shards_.size();
+		}
+
+		bool try_pop_any(task_type& work, std::size_t home_shard)
+		{
+			if(shards_.size() == 1)
+			{
+				return false;
+			}
+
+			for(std::size_t i = 0; i < shards_.size(); ++i)
+			{
+				auto& shard = shards_[(home_shard + i) % shards_.size()];
+				if(shard->try_pop(work) == QueueOpStatus::success)
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		static worker_state make_worker_state(std::size_t index)
+		{
+			if constexpr(std::constructible_from<worker_state, std::size_t>)
+			{
+				return worker_state(index);
+			}
+			else
+			{
+				static_cast<void>(index);
+				return worker_state();
+			}
+		}
+
+		void worker_main(std::size_t index, std::size_t home_shard, detail::Latch* workers_started)
+		{
+			worker_state state = make_worker_state(index);
+			detail::this_worker = detail::WorkerContext{this, &type_tag_, index, &state};
+			if(workers_started != nullptr)
+			{
+				workers_started->count_down();
+			}
+
+			worker_loop(home_shard, activity_[index].busy);
+
+			detail::this_worker = detail::WorkerContext{};
+		}
+
+		void begin_blocking()
+		{
+			std::scoped_lock lock(compensation_mutex_);
+			++blocked_;
+
+			if(stopping_ || active_compensators_ >= std::min(blocked_, max_compensating_))
+			{
+				return;
+			}
+
+			reap_compensators_locked();
+			start_compensator_locked();
+		}
+
+		void end_blocking()
+		{
+			std::scoped_lock lock(compensation_mutex_);
+			--blocked_;
+		}
+
+		void reap_compensators_locked()
+		{
+			std::erase_if(
+					compensators_,
+					[](auto& compensator)
+					{
+						if(!compensator->finished.load())
+						{
+							return false;
+						}
+						compensator->thread.join();
+						return true;
+					}
+			);
+		}
+
+		void start_compensator_locked()
+		{
+			std::size_t slot = 0;
+			while(std::any_of(
+					compensators_.begin(),
+					compensators_.end(),
+					[slot](const auto& compensator) { return compensator->slot == slot; }
+			))
+			{
+				++slot;
+			}
+
+			auto compensator = std::make_unique<Compensator>();
+			compensator->slot = slot;
+
+			const std::size_t index = worker_count_ + slot;
+			compensator->thread = thread_factory_.create(
+					index,
+					[this, index, compensator = compensator.get()]()
+					{
+						compensator_main(index, *compensator);
+					}
+			);
+
+			compensators_.push_back(std::move(compensator));
+			++active_compensators_;
+		}
+
+		bool retire_if_surplus()
+		{
+			std::scoped_lock lock(compensation_mutex_);
+			if(active_compensators_ > std::min(blocked_, max_compensating_))
+			{
+				--active_compensators_;
+				return true;
+			}
+			return false;
+		}
+
+		void compensator_main(std::size_t index, Compensator& self)
+		{
+			{
+				worker_state state = make_worker_state(index);
+				detail::this_worker = detail::WorkerContext{this, &type_tag_, index, &state};
+
+				compensator_loop(self.slot % shards_.size());
+
+				detail::this_worker = detail::WorkerContext{};
+			}
+
+			// last access to self, the thread may be joined from now on
+			self.finished.store(true);
+		}
+
+		void compensator_loop(std::size_t home_shard)
+		{
+			task_type work;
+			while(!retire_if_surplus())
+			{
+				if(try_pop_any(work, home_shard))
+				{
+					run_compensating(work);
+					continue;
+				}
+
+				auto state = shards_[home_shard]->wait_pop_for(work, compensation_poll_interval);
+				if(state == QueueOpStatus::success)
+				{
+					run_compensating(work);
+				}
+				else if(state == QueueOpStatus::closed)
+				{
+					std::scoped_lock lock(compensation_mutex_);
+					--active_compensators_;
+					return;
+				}
+			}
+		}
+
+		void run_task(task_type& work, std::atomic<bool>& busy)
+		{
+			spawn_for_backlog();
+			busy.store(true, std::memory_order_relaxed);
+			work();
+			busy.store(false, std::memory_order_relaxed);
+		}
+
+		void run_compensating(task_type& work)
+		{
+			busy_compensators_.fetch_add(1, std::memory_order_relaxed);
+			work();
+			busy_compensators_.fetch_sub(1, std::memory_order_relaxed);
+		}
+
+		static QueueStats queue_stats(const queue_type& queue)
+		{
+			if constexpr(requires { { queue.stats() } -> std::same_as<QueueStats>; })
+			{
+				return queue.stats();
+			}
+			else if constexpr(requires { { queue.size() } -> std::convertible_to<std::size_t>; })
+			{
+				return QueueStats{queue.size(), 0, queue.closed()};
+			}
+			else
+			{
+				return QueueStats{0, 0, queue.closed()};
+			}
+		}
+
+		// a sharded pool parks idle workers on idle_ instead of a shard, so work behind a busy worker is stolen
+		QueueOpStatus park(std::size_t home_shard, task_type& work)
+		{
+			if(shards_.size() == 1)
+			{
+				return wait_strategy::wait_pop(*shards_[home_shard], work);
+			}
+			if constexpr(requires(bool (*poll)()) { wait_strategy::spin(poll); })
+			{
+				if(wait_strategy::spin([&](){ return try_pop_any(work, home_shard); }))
+				{
+					return QueueOpStatus::success;
+				}
+			}
+
+			// registered before the last scan, so a task pushed after it wakes this worker
+			const EventCount::Key key = idle_.prepare_wait();
+			if(try_pop_any(work, home_shard))
+			{
+				idle_.cancel_wait();
+				return QueueOpStatus::success;
+			}
+			if(closing_.load())
+			{
+				idle_.cancel_wait();
+				return QueueOpStatus::closed;
+			}
+			idle_.commit_wait(key);
+			return QueueOpStatus::empty;
+		}
+
+		void worker_loop(std::size_t home_shard, std::atomic<bool>& busy)
+		{
+			task_type work;
+			while(true)
+			{
+				if(try_pop_any(work, home_shard))
+				{
+					run_task(work, busy);
+					continue;
+				}
+
+				shard_activity_[home_shard].parked.fetch_add(1, std::memory_order_relaxed);
+				auto state = park(home_shard, work);
+				shard_activity_[home_shard].parked.fetch_sub(1, std::memory_order_relaxed);
+				if(state == QueueOpStatus::closed)
+				{
+					break;
+				}
+				if(state == QueueOpStatus::success)
+				{
+					run_task(work, busy);
+				}
+			}
+
+			// home shard is closed and drained, help with leftovers of the others
+			while(try_pop_any(work, home_shard))
+			{
+				run_task(work, busy);
+			}
+		}
 	};
 }
 
-#endif //THREAD_POOL_THREAD_POOL_HPP
\ No newline at end of file
+#endif //THREAD_POOL_THREAD_POOL_HPP
@@ -0,0 +1,294 @@
+#ifndef THREAD_POOL_TRACE_CHROME_TRACER_HPP
+#define THREAD_POOL_TRACE_CHROME_TRACER_HPP
+
+#include "thread_pool/policy.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <new>
+#include <ostream>
+
+
+namespace thread_pool
+{
+	/**
+	 * Metrics hook recording enqueue, start and end time, worker and label of every task.
+	 *
+	 * Every worker writes into its own fixed-size ring buffer without locking (the oldest events
+	 * are overwritten). write_chrome_trace() may be called at any time and exports the buffered events
+	 * in Chrome trace_event JSON format, readable by chrome://tracing and Perfetto.
+	 *
+	 * Usage: struct TracedPolicy: DefaultPolicy { using metrics = ChromeTracer; };
+	 */
+	class ChromeTracer
+	{
+	public:
+		static constexpr bool enabled = true;
+
+		static constexpr std::size_t default_buffer_size = 4096;
+		static constexpr std::size_t default_max_workers = 256;
+
+		struct task_token
+		{
+			std::int64_t enqueue_ns;
+			std::int64_t start_ns;
+			const char* label;
+		};
+
+		explicit ChromeTracer(
+				std::size_t buffer_size = default_buffer_size,
+				std::size_t max_workers = default_max_workers
+		);
+		~ChromeTracer();
+
+		ChromeTracer(const ChromeTracer&) = delete;
+		ChromeTracer& operator=(const ChromeTracer&) = delete;
+
+		task_token on_enqueue(TaskLabel label) const noexcept;
+		void on_task_start(task_token& token, std::size_t worker) const noexcept;
+		void on_task_end(task_token& token, std::size_t worker) noexcept;
+
+		void write_chrome_trace(std::ostream& out) const;
+
+		/**
+		 * Number of events which could not be recorded (worker index above max_workers or allocation failure).
+		 */
+		[[nodiscard]] std::size_t dropped() const noexcept;
+
+	private:
+		// single writer seqlock: odd sequence while the event is being written. Fields are stored with release
+		// and loaded with acquire instead of using fences (which TSAN does not model), so a reader seeing
+		// a field of a newer write also sees its odd sequence on the recheck
+		struct Event
+		{
+			std::atomic<std::uint64_t> sequence = 0;
+			std::atomic<std::int64_t> enqueue_ns = 0;
+			std::atomic<std::int64_t> start_ns = 0;
+			std::atomic<std::int64_t> end_ns = 0;
+			std::atomic<const char*> label = nullptr;
+		};
+
+		struct WorkerBuffer
+		{
+			explicit WorkerBuffer(std::size_t size)
+			:
+				events(std::make_unique<Event[]>(size))
+			{}
+
+			std::unique_ptr<Event[]> events;
+			std::atomic<std::uint64_t> written = 0;
+		};
+
+		std::chrono::steady_clock::time_point epoch_;
+		std::size_t buffer_size_;
+		std::size_t max_workers_;
+		std::unique_ptr<std::atomic<WorkerBuffer*>[]> buffers_;
+		std::atomic<std::size_t> dropped_ = 0;
+
+		std::int64_t now_ns() const noexcept;
+		WorkerBuffer* buffer_for(std::size_t worker) noexcept;
+
+		static void write_string(std::ostream& out, const char* value);
+		static void write_us(std::ostream& out, std::int64_t ns);
+	};
+
+	inline ChromeTracer::ChromeTracer(std::size_t buffer_size, std::size_t max_workers)
+	:
+		epoch_(std::chrono::steady_clock::now()),
+		buffer_size_(buffer_size == 0 ? 1 : buffer_size),
+		max_workers_(max_workers),
+		buffers_(std::make_unique<std::atomic<WorkerBuffer*>[]>(max_workers))
+	{
+		for(std::size_t i = 0; i < max_workers_; ++i)
+		{
+			buffers_[i].store(nullptr, std::memory_order_relaxed);
+		}
+	}
+
+	inline ChromeTracer::~ChromeTracer()
+	{
+		for(std::size_t i = 0; i < max_workers_; ++i)
+		{
+			delete buffers_[i].load(std::memory_order_acquire);
+		}
+	}
+
+	inline ChromeTracer::task_token ChromeTracer::on_enqueue(TaskLabel label) const noexcept
+	{
+		return task_token{now_ns(), 0, label.name};
+	}
+
+	inline void ChromeTracer::on_task_start(task_token& token, std::size_t) const noexcept
+	{
+		token.start_ns = now_ns();
+	}
+
+	inline void ChromeTracer::on_task_end(task_token& token, std::size_t worker) noexcept
+	{
+		const std::int64_t end_ns = now_ns();
+
+		WorkerBuffer* buffer = buffer_for(worker);
+		if(buffer == nullptr)
+		{
+			dropped_.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		const std::uint64_t index = buffer->written.load(std::memory_order_relaxed);
+		Event& event = buffer->events[index % buffer_size_];
+
+		event.sequence.store(2 * index + 1, std::memory_order_relaxed);
+
+		event.enqueue_ns.store(token.enqueue_ns, std::memory_order_release);
+		event.start_ns.store(token.start_ns, std::memory_order_release);
+		event.end_ns.store(end_ns, std::memory_order_release);
+		event.label.store(token.label, std::memory_order_release);
+
+		event.sequence.store(2 * index + 2, std::memory_order_release);
+		buffer->written.store(index + 1, std::memory_order_release);
+	}
+
+	inline void ChromeTracer::write_chrome_trace(std::ostream& out) const
+	{
+		out << "{\"traceEvents\":[";
+
+		bool first = true;
+		for(std::size_t worker = 0; worker < max_workers_; ++worker)
+		{
+			const WorkerBuffer* buffer = buffers_[worker].load(std::memory_order_acquire);
+			if(buffer == nullptr)
+			{
+				continue;
+			}
+
+			out << (first ? "" : ",")
+			    << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << worker
+			    << ",\"args\":{\"name\":\"worker " << worker << "\"}}";
+			first = false;
+
+			const std::uint64_t written = buffer->written.load(std::memory_order_acquire);
+			const std::uint64_t begin = written > buffer_size_ ? written - buffer_size_ : 0;
+			for(std::uint64_t index = begin; index < written; ++index)
+			{
+				const Event& event = buffer->events[index % buffer_size_];
+
+				const std::uint64_t sequence = event.sequence.load(std::memory_order_acquire);
+				if(sequence != 2 * index + 2)
+				{
+					continue;
+				}
+
+				const std::int64_t enqueue_ns = event.enqueue_ns.load(std::memory_order_acquire);
+				const std::int64_t start_ns = event.start_ns.load(std::memory_order_acquire);
+				const std::int64_t end_ns = event.end_ns.load(std::memory_order_acquire);
+				const char* label = event.label.load(std::memory_order_acquire);
+
+				if(event.sequence.load(std::memory_order_relaxed) != sequence)
+				{
+					// overwritten while reading
+					continue;
+				}
+
+				out << ",\n{\"name\":";
+				write_string(out, label == nullptr ? "task" : label);
+				out << ",\"cat\":\"task\",\"ph\":\"X\",\"pid\":1,\"tid\":" << worker << ",\"ts\":";
+				write_us(out, start_ns);
+				out << ",\"dur\":";
+				write_us(out, end_ns - start_ns);
+				out << ",\"args\":{\"queue_wait_us\":";
+				write_us(out, start_ns - enqueue_ns);
+				out << "}}";
+			}
+		}
+
+		out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+	}
+
+	inline std::size_t ChromeTracer::dropped() const noexcept
+	{
+		return dropped_.load(std::memory_order_relaxed);
+	}
+
+	inline std::int64_t ChromeTracer::now_ns() const noexcept
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch_).count();
+	}
+
+	inline ChromeTracer::WorkerBuffer* ChromeTracer::buffer_for(std::size_t worker) noexcept
+	{
+		if(worker >= max_workers_)
+		{
+			return nullptr;
+		}
+
+		WorkerBuffer* buffer = buffers_[worker].load(std::memory_order_acquire);
+		if(buffer != nullptr)
+		{
+			return buffer;
+		}
+
+		WorkerBuffer* created = nullptr;
+		try
+		{
+			created = new WorkerBuffer(buffer_size_);
+		}
+		catch(const std::bad_alloc&)
+		{
+			return nullptr;
+		}
+
+		if(!buffers_[worker].compare_exchange_strong(buffer, created, std::memory_order_acq_rel))
+		{
+			delete created;
+			return buffer;
+		}
+		return created;
+	}
+
+	inline void ChromeTracer::write_string(std::ostream& out, const char* value)
+	{
+		out << '"';
+		for(; *value != '\0'; ++value)
+		{
+			const char c = *value;
+			if(c == '"' || c == '\\')
+			{
+				out << '\\' << c;
+			}
+			else if(static_cast<unsigned char>(c) < 0x20)
+			{
+				char escaped[8];
+				std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+				out << escaped;
+			}
+			else
+			{
+				out << c;
+			}
+		}
+		out << '"';
+	}
+
+	inline void ChromeTracer::write_us(std::ostream& out, std::int64_t ns)
+	{
+		if(ns < 0)
+		{
+			ns = 0;
+		}
+
+		char formatted[32];
+		std::snprintf(
+				formatted,
+				sizeof(formatted),
+				"%lld.%03lld",
+				static_cast<long long>(ns / 1000),
+				static_cast<long long>(ns % 1000)
+		);
+		out << formatted;
+	}
+}
+
+#endif //THREAD_POOL_TRACE_CHROME_TRACER_HPP
@@ -0,0 +1,310 @@
+#ifndef THREAD_POOL_TRACE_WATCHDOG_HPP
+#define THREAD_POOL_TRACE_WATCHDOG_HPP
+
+#include "thread_pool/policy.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace thread_pool
+{
+	struct StallReport
+	{
+		enum class Kind
+		{
+			task,
+			queue
+		};
+
+		static constexpr std::size_t no_worker = std::numeric_limits<std::size_t>::max();
+
+		Kind kind;
+		// no_worker for queue stalls
+		std::size_t worker;
+		const char* label;
+		std::chrono::nanoseconds elapsed;
+		std::size_t queue_depth;
+	};
+
+	struct WatchdogOptions
+	{
+		// zero disables the check
+		std::chrono::nanoseconds task_threshold = std::chrono::seconds(1);
+		std::chrono::nanoseconds queue_threshold = std::chrono::seconds(1);
+		std::chrono::nanoseconds interval = std::chrono::milliseconds(100);
+	};
+
+	/**
+	 * Metrics hook detecting tasks running for too long and queues which are not drained.
+	 *
+	 * Workers publish the start time and label of their current task in per-worker slots, producers
+	 * stamp every enqueue into a ring of timestamps. Both are plain atomic stores, the queues themselves
+	 * are never locked. After start() a background thread samples the slots every interval and reports
+	 * a task once when it runs longer than task_threshold, and the queue once per oldest task when it
+	 * waits longer than queue_threshold. Queue depth and oldest wait are estimates assuming FIFO order
+	 * (with several shards or more than ring_size queued tasks the wait is underestimated).
+	 *
+	 * Usage: struct WatchedPolicy: DefaultPolicy { using metrics = Watchdog; };
+	 *        pool.metrics().start(WatchdogOptions{}, callback);
+	 */
+	class Watchdog
+	{
+	public:
+		static constexpr bool enabled = true;
+
+		static constexpr std::size_t default_ring_size = 1024;
+		static constexpr std::size_t default_max_workers = 256;
+
+		using callback_type = std::function<void(const StallReport&)>;
+
+		struct task_token
+		{
+			const char* label;
+		};
+
+		explicit Watchdog(std::size_t ring_size = default_ring_size, std::size_t max_workers = default_max_workers);
+		~Watchdog();
+
+		Watchdog(const Watchdog&) = delete;
+		Watchdog& operator=(const Watchdog&) = delete;
+
+		task_token on_enqueue(TaskLabel label) noexcept;
+		void on_task_start(task_token& token, std::size_t worker) noexcept;
+		void on_task_end(task_token& token, std::size_t worker) noexcept;
+		void on_discard(task_token& token) noexcept;
+
+		/**
+		 * Starts the sampling thread, restarting it if already running. Callback runs on that thread.
+		 */
+		void start(WatchdogOptions options, callback_type callback);
+		void stop();
+
+		/**
+		 * Runs one sampling round on the calling thread, must not be used while the sampling thread runs.
+		 */
+		void check(const WatchdogOptions& options, const callback_type& callback);
+
+		[[nodiscard]] std::size_t queue_depth() const noexcept;
+
+	private:
+		// single writer seqlock: odd sequence while the slot is being written, start_ns is 0 when idle.
+		// Release stores and acquire loads of the fields replace fences, see ChromeTracer::Event
+		struct alignas(64) WorkerSlot
+		{
+			std::atomic<std::uint64_t> sequence = 0;
+			std::atomic<std::int64_t> start_ns = 0;
+			std::atomic<const char*> label = nullptr;
+		};
+
+		struct EnqueueStamp
+		{
+			std::atomic<std::uint64_t> index = std::numeric_limits<std::uint64_t>::max();
+			std::atomic<std::int64_t> enqueue_ns = 0;
+		};
+
+		std::chrono::steady_clock::time_point epoch_;
+		std::size_t ring_size_;
+		std::size_t max_workers_;
+		std::unique_ptr<WorkerSlot[]> slots_;
+		std::unique_ptr<EnqueueStamp[]> stamps_;
+
+		alignas(64) std::atomic<std::uint64_t> enqueued_ = 0;
+		alignas(64) std::atomic<std::uint64_t> started_ = 0;
+
+		// owned by the sampling thread
+		std::vector<std::uint64_t> reported_;
+		std::uint64_t reported_queue_ = std::numeric_limits<std::uint64_t>::max();
+
+		std::mutex mutex_;
+		std::condition_variable stop_cv_;
+		bool stopping_ = false;
+		std::thread thread_;
+
+		std::int64_t now_ns() const noexcept;
+		void write_slot(WorkerSlot& slot, std::int64_t start_ns, const char* label) noexcept;
+		void run(WatchdogOptions options, callback_type callback);
+	};
+
+	inline Watchdog::Watchdog(std::size_t ring_size, std::size_t max_workers)
+	:
+		epoch_(std::chrono::steady_clock::now()),
+		ring_size_(ring_size == 0 ? 1 : ring_size),
+		max_workers_(max_workers),
+		slots_(std::make_unique<WorkerSlot[]>(max_workers)),
+		stamps_(std::make_unique<EnqueueStamp[]>(ring_size_)),
+		reported_(max_workers, 0)
+	{}
+
+	inline Watchdog::~Watchdog()
+	{
+		stop();
+	}
+
+	inline Watchdog::task_token Watchdog::on_enqueue(TaskLabel label) noexcept
+	{
+		const std::uint64_t index = enqueued_.fetch_add(1, std::memory_order_relaxed);
+
+		// concurrent producers may complete out of order, the index tells the reader which enqueue it sees
+		EnqueueStamp& stamp = stamps_[index % ring_size_];
+		stamp.index.store(std::numeric_limits<std::uint64_t>::max(), std::memory_order_relaxed);
+		stamp.enqueue_ns.store(now_ns(), std::memory_order_release);
+		stamp.index.store(index, std::memory_order_release);
+
+		return task_token{label.name};
+	}
+
+	inline void Watchdog::on_task_start(task_token& token, std::size_t worker) noexcept
+	{
+		started_.fetch_add(1, std::memory_order_relaxed);
+		if(worker < max_workers_)
+		{
+			// 0 marks an idle slot
+			write_slot(slots_[worker], std::max<std::int64_t>(now_ns(), 1), token.label);
+		}
+	}
+
+	inline void Watchdog::on_task_end(task_token&, std::size_t worker) noexcept
+	{
+		if(worker < max_workers_)
+		{
+			write_slot(slots_[worker], 0, nullptr);
+		}
+	}
+
+	inline void Watchdog::on_discard(task_token&) noexcept
+	{
+		// a dropped task left the queue as well, without it queue_depth() would never get back to 0
+		started_.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	inline void Watchdog::start(WatchdogOptions options, callback_type callback)
+	{
+		stop();
+
+		std::scoped_lock lock(mutex_);
+		stopping_ = false;
+		thread_ = std::thread(&Watchdog::run, this, options, std::move(callback));
+	}
+
+	inline void Watchdog::stop()
+	{
+		{
+			std::scoped_lock lock(mutex_);
+			stopping_ = true;
+			stop_cv_.notify_all();
+		}
+
+		if(thread_.joinable())
+		{
+			thread_.join();
+		}
+	}
+
+	inline void Watchdog::check(const WatchdogOptions& options, const callback_type& callback)
+	{
+		const std::int64_t now = now_ns();
+
+		if(options.task_threshold.count() > 0)
+		{
+			for(std::size_t worker = 0; worker < max_workers_; ++worker)
+			{
+				const WorkerSlot& slot = slots_[worker];
+
+				const std::uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+				if(sequence % 2 == 1 || sequence == reported_[worker])
+				{
+					continue;
+				}
+
+				const std::int64_t start_ns = slot.start_ns.load(std::memory_order_acquire);
+				const char* label = slot.label.load(std::memory_order_acquire);
+
+				if(slot.sequence.load(std::memory_order_relaxed) != sequence || start_ns == 0)
+				{
+					continue;
+				}
+
+				const std::chrono::nanoseconds elapsed(now - start_ns);
+				if(elapsed >= options.task_threshold)
+				{
+					reported_[worker] = sequence;
+					callback(StallReport{StallReport::Kind::task, worker, label, elapsed, queue_depth()});
+				}
+			}
+		}
+
+		if(options.queue_threshold.count() > 0)
+		{
+			const std::uint64_t started = started_.load(std::memory_order_relaxed);
+			const std::uint64_t enqueued = enqueued_.load(std::memory_order_relaxed);
+			if(enqueued <= started || started == reported_queue_)
+			{
+				return;
+			}
+
+			// a newer enqueue in the slot only underestimates the wait, an unpublished one is skipped
+			const EnqueueStamp& stamp = stamps_[started % ring_size_];
+			const std::uint64_t index = stamp.index.load(std::memory_order_acquire);
+			const std::int64_t enqueue_ns = stamp.enqueue_ns.load(std::memory_order_acquire);
+			if(index == std::numeric_limits<std::uint64_t>::max() || index < started
+					|| stamp.index.load(std::memory_order_relaxed) != index)
+			{
+				return;
+			}
+
+			const std::chrono::nanoseconds elapsed(now - enqueue_ns);
+			if(elapsed >= options.queue_threshold)
+			{
+				reported_queue_ = started;
+				callback(StallReport{StallReport::Kind::queue, StallReport::no_worker, nullptr, elapsed, enqueued - started});
+			}
+		}
+	}
+
+	inline std::size_t Watchdog::queue_depth() const noexcept
+	{
+		const std::uint64_t started = started_.load(std::memory_order_relaxed);
+		const std::uint64_t enqueued = enqueued_.load(std::memory_order_relaxed);
+		return enqueued > started ? enqueued - started : 0;
+	}
+
+	inline std::int64_t Watchdog::now_ns() const noexcept
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch_).count();
+	}
+
+	inline void Watchdog::write_slot(WorkerSlot& slot, std::int64_t start_ns, const char* label) noexcept
+	{
+		const std::uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+
+		slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+
+		slot.start_ns.store(start_ns, std::memory_order_release);
+		slot.label.store(label, std::memory_order_release);
+
+		slot.sequence.store(sequence + 2, std::memory_order_release);
+	}
+
+	inline void Watchdog::run(WatchdogOptions options, callback_type callback)
+	{
+		std::unique_lock lock(mutex_);
+		while(!stop_cv_.wait_for(lock, options.interval, [this](){ return stopping_; }))
+		{
+			lock.unlock();
+			check(options, callback);
+			lock.lock();
+		}
+	}
+}
+
+#endif //THREAD_POOL_TRACE_WATCHDOG_HPP
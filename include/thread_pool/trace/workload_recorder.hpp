@@ -0,0 +1,271 @@
+#ifndef THREAD_POOL_TRACE_WORKLOAD_RECORDER_HPP
+#define THREAD_POOL_TRACE_WORKLOAD_RECORDER_HPP
+
+#include "thread_pool/policy.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+namespace thread_pool
+{
+	struct WorkloadEvent
+	{
+		// submission time relative to the start of the recording
+		std::chrono::nanoseconds submit_time;
+		// small index of the submitting thread, stable within one recording
+		std::size_t submitter;
+		// how long the task ran on a worker
+		std::chrono::nanoseconds duration;
+		std::string label;
+	};
+
+	/**
+	 * Recorded task submissions ordered by submit_time, the input of replay_workload().
+	 *
+	 * Saved as CSV: a "submit_ns,submitter,duration_ns,label" header and one line per task.
+	 */
+	struct WorkloadTrace
+	{
+		std::vector<WorkloadEvent> events;
+
+		void write(std::ostream& out) const;
+		static WorkloadTrace read(std::istream& in);
+	};
+
+	/**
+	 * Metrics hook recording submission time, submitting thread and run time of every task.
+	 *
+	 * Every worker appends to its own log under a mutex only trace() ever contends for. Unlike
+	 * ChromeTracer nothing is overwritten, a recording keeps every task until clear().
+	 *
+	 * Usage: struct RecordingPolicy: DefaultPolicy { using metrics = WorkloadRecorder; };
+	 */
+	class WorkloadRecorder
+	{
+	public:
+		static constexpr bool enabled = true;
+
+		static constexpr std::size_t default_max_workers = 256;
+
+		struct task_token
+		{
+			std::int64_t submit_ns;
+			std::int64_t start_ns;
+			std::size_t submitter;
+			const char* label;
+		};
+
+		explicit WorkloadRecorder(std::size_t max_workers = default_max_workers);
+
+		WorkloadRecorder(const WorkloadRecorder&) = delete;
+		WorkloadRecorder& operator=(const WorkloadRecorder&) = delete;
+
+		task_token on_enqueue(TaskLabel label) noexcept;
+		void on_task_start(task_token& token, std::size_t worker) const noexcept;
+		void on_task_end(task_token& token, std::size_t worker) noexcept;
+
+		/**
+		 * Tasks finished so far. Submitters are renumbered from 0 in order of their first submission.
+		 */
+		[[nodiscard]] WorkloadTrace trace() const;
+		void clear();
+
+		/**
+		 * Number of tasks which could not be recorded (worker index above max_workers or allocation failure).
+		 */
+		[[nodiscard]] std::size_t dropped() const noexcept;
+
+	private:
+		struct Record
+		{
+			std::int64_t submit_ns;
+			std::int64_t duration_ns;
+			std::size_t submitter;
+			const char* label;
+		};
+
+		struct alignas(64) WorkerLog
+		{
+			mutable std::mutex mutex;
+			std::vector<Record> records;
+		};
+
+		std::chrono::steady_clock::time_point epoch_;
+		std::size_t max_workers_;
+		std::unique_ptr<WorkerLog[]> logs_;
+		std::atomic<std::size_t> dropped_ = 0;
+
+		std::int64_t now_ns() const noexcept;
+		static std::size_t submitter_id() noexcept;
+	};
+
+	inline void WorkloadTrace::write(std::ostream& out) const
+	{
+		out << "submit_ns,submitter,duration_ns,label\n";
+		for(const auto& event: events)
+		{
+			out << event.submit_time.count() << ',' << event.submitter << ',' << event.duration.count() << ','
+					<< event.label << '\n';
+		}
+	}
+
+	inline WorkloadTrace WorkloadTrace::read(std::istream& in)
+	{
+		WorkloadTrace trace;
+
+		std::string line;
+		if(!std::getline(in, line) || line.rfind("submit_ns,", 0) != 0)
+		{
+			throw std::runtime_error("Missing workload trace header");
+		}
+
+		while(std::getline(in, line))
+		{
+			if(line.empty())
+			{
+				continue;
+			}
+
+			std::istringstream fields(line);
+			std::int64_t submit_ns = 0;
+			std::size_t submitter = 0;
+			std::int64_t duration_ns = 0;
+			char comma_1 = 0;
+			char comma_2 = 0;
+			char comma_3 = 0;
+			if(!(fields >> submit_ns >> comma_1 >> submitter >> comma_2 >> duration_ns >> comma_3)
+					|| comma_1 != ',' || comma_2 != ',' || comma_3 != ',')
+			{
+				throw std::runtime_error("Malformed workload trace line: " + line);
+			}
+
+			std::string label;
+			std::getline(fields, label);
+			trace.events.push_back(WorkloadEvent{
+					std::chrono::nanoseconds(submit_ns),
+					submitter,
+					std::chrono::nanoseconds(duration_ns),
+					std::move(label)
+			});
+		}
+
+		std::stable_sort(trace.events.begin(), trace.events.end(), [](const auto& lhs, const auto& rhs){
+			return lhs.submit_time < rhs.submit_time;
+		});
+		return trace;
+	}
+
+	inline WorkloadRecorder::WorkloadRecorder(std::size_t max_workers)
+	:
+		epoch_(std::chrono::steady_clock::now()),
+		max_workers_(max_workers),
+		logs_(std::make_unique<WorkerLog[]>(max_workers))
+	{}
+
+	inline WorkloadRecorder::task_token WorkloadRecorder::on_enqueue(TaskLabel label) noexcept
+	{
+		return task_token{now_ns(), 0, submitter_id(), label.name};
+	}
+
+	inline void WorkloadRecorder::on_task_start(task_token& token, std::size_t) const noexcept
+	{
+		token.start_ns = now_ns();
+	}
+
+	inline void WorkloadRecorder::on_task_end(task_token& token, std::size_t worker) noexcept
+	{
+		const std::int64_t end_ns = now_ns();
+		if(worker >= max_workers_)
+		{
+			dropped_.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		WorkerLog& log = logs_[worker];
+		try
+		{
+			std::scoped_lock lock(log.mutex);
+			log.records.push_back(Record{token.submit_ns, end_ns - token.start_ns, token.submitter, token.label});
+		}
+		catch(...)
+		{
+			dropped_.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	inline WorkloadTrace WorkloadRecorder::trace() const
+	{
+		std::vector<Record> records;
+		for(std::size_t i = 0; i < max_workers_; ++i)
+		{
+			std::scoped_lock lock(logs_[i].mutex);
+			records.insert(records.end(), logs_[i].records.begin(), logs_[i].records.end());
+		}
+
+		std::stable_sort(records.begin(), records.end(), [](const auto& lhs, const auto& rhs){
+			return lhs.submit_ns < rhs.submit_ns;
+		});
+
+		WorkloadTrace trace;
+		trace.events.reserve(records.size());
+
+		std::vector<std::size_t> submitters;
+		const std::int64_t origin = records.empty() ? 0 : records.front().submit_ns;
+		for(const auto& record: records)
+		{
+			auto submitter = std::find(submitters.begin(), submitters.end(), record.submitter);
+			if(submitter == submitters.end())
+			{
+				submitter = submitters.insert(submitters.end(), record.submitter);
+			}
+
+			trace.events.push_back(WorkloadEvent{
+					std::chrono::nanoseconds(record.submit_ns - origin),
+					static_cast<std::size_t>(submitter - submitters.begin()),
+					std::chrono::nanoseconds(record.duration_ns),
+					record.label != nullptr ? record.label : ""
+			});
+		}
+		return trace;
+	}
+
+	inline void WorkloadRecorder::clear()
+	{
+		for(std::size_t i = 0; i < max_workers_; ++i)
+		{
+			std::scoped_lock lock(logs_[i].mutex);
+			logs_[i].records.clear();
+		}
+		dropped_.store(0, std::memory_order_relaxed);
+	}
+
+	inline std::size_t WorkloadRecorder::dropped() const noexcept
+	{
+		return dropped_.load(std::memory_order_relaxed);
+	}
+
+	inline std::int64_t WorkloadRecorder::now_ns() const noexcept
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch_).count();
+	}
+
+	inline std::size_t WorkloadRecorder::submitter_id() noexcept
+	{
+		static std::atomic<std::size_t> next_id = 0;
+		static thread_local const std::size_t id = next_id.fetch_add(1, std::memory_order_relaxed);
+		return id;
+	}
+}
+
+#endif //THREAD_POOL_TRACE_WORKLOAD_RECORDER_HPP
@@ -0,0 +1,167 @@
+#ifndef THREAD_POOL_TRACE_WORKLOAD_REPLAY_HPP
+#define THREAD_POOL_TRACE_WORKLOAD_REPLAY_HPP
+
+#include "workload_recorder.hpp"
+#include "thread_pool/detail/_latch.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+
+namespace thread_pool
+{
+	struct LatencySummary
+	{
+		std::chrono::nanoseconds p50{0};
+		std::chrono::nanoseconds p90{0};
+		std::chrono::nanoseconds p99{0};
+		std::chrono::nanoseconds max{0};
+	};
+
+	struct ReplayOptions
+	{
+		// submit times are multiplied by time_scale, below 1 replays the trace faster
+		double time_scale = 1.0;
+		// task durations are multiplied by work_scale
+		double work_scale = 1.0;
+	};
+
+	struct ReplayResult
+	{
+		std::size_t tasks = 0;
+		// from the scheduled start of the trace (its submit_time 0) to the last completion
+		std::chrono::nanoseconds makespan{0};
+		double tasks_per_second = 0.0;
+		// submission to task start
+		LatencySummary queue_wait;
+		// submission to task end
+		LatencySummary end_to_end;
+	};
+
+	namespace detail
+	{
+		inline LatencySummary summarize(std::vector<std::chrono::nanoseconds>& samples)
+		{
+			LatencySummary summary;
+			if(samples.empty())
+			{
+				return summary;
+			}
+
+			std::sort(samples.begin(), samples.end());
+			const auto at = [&samples](double fraction)
+			{
+				return samples[static_cast<std::size_t>(fraction * static_cast<double>(samples.size() - 1))];
+			};
+			summary.p50 = at(0.5);
+			summary.p90 = at(0.9);
+			summary.p99 = at(0.99);
+			summary.max = samples.back();
+			return summary;
+		}
+	}
+
+	/**
+	 * Replays trace against pool: one thread per recorded submitter enqueues its tasks at the recorded
+	 * offsets, each task busy-waits for its recorded duration. Blocks until every task finished.
+	 *
+	 * Works with any ThreadPool configuration, so queues and schedulers can be compared on the same
+	 * recorded traffic. Busy-waiting tasks need as many cores as the recording had to be representative.
+	 */
+	template<typename Pool>
+	ReplayResult replay_workload(Pool& pool, const WorkloadTrace& trace, ReplayOptions options = {})
+	{
+		using clock = std::chrono::steady_clock;
+
+		struct Timing
+		{
+			clock::time_point submit;
+			clock::time_point start;
+			clock::time_point end;
+		};
+
+		const auto& events = trace.events;
+		std::vector<Timing> timings(events.size());
+		if(events.empty())
+		{
+			return ReplayResult{};
+		}
+
+		std::size_t submitter_count = 0;
+		for(const auto& event: events)
+		{
+			submitter_count = std::max(submitter_count, event.submitter + 1);
+		}
+
+		detail::Latch finished(static_cast<std::ptrdiff_t>(events.size()));
+		// submitters start their clocks together after all of them are running
+		const auto origin = clock::now() + std::chrono::milliseconds(10);
+
+		std::vector<std::thread> submitters;
+		submitters.reserve(submitter_count);
+		for(std::size_t submitter = 0; submitter < submitter_count; ++submitter)
+		{
+			submitters.emplace_back([&, submitter]()
+			{
+				for(std::size_t i = 0; i < events.size(); ++i)
+				{
+					if(events[i].submitter != submitter)
+					{
+						continue;
+					}
+
+					std::this_thread::sleep_until(origin + std::chrono::duration_cast<clock::duration>(events[i].submit_time * options.time_scale));
+
+					const auto work = std::chrono::duration_cast<clock::duration>(events[i].duration * options.work_scale);
+					Timing& timing = timings[i];
+					timing.submit = clock::now();
+					static_cast<void>(pool.enqueue([&timing, &finished, work]()
+					{
+						timing.start = clock::now();
+						const auto until = timing.start + work;
+						while(clock::now() < until)
+						{
+						}
+						timing.end = clock::now();
+						finished.count_down();
+					}));
+				}
+			});
+		}
+
+		for(auto& submitter: submitters)
+		{
+			submitter.join();
+		}
+		finished.wait();
+
+		ReplayResult result;
+		result.tasks = events.size();
+
+		std::vector<std::chrono::nanoseconds> waits;
+		std::vector<std::chrono::nanoseconds> latencies;
+		waits.reserve(timings.size());
+		latencies.reserve(timings.size());
+
+		// measured from the schedule, a late first submission counts against the pool instead of shortening the run
+		auto last_end = origin;
+		for(const auto& timing: timings)
+		{
+			last_end = std::max(last_end, timing.end);
+			waits.push_back(timing.start - timing.submit);
+			latencies.push_back(timing.end - timing.submit);
+		}
+
+		result.makespan = last_end - origin;
+		const double seconds = std::chrono::duration<double>(result.makespan).count();
+		result.tasks_per_second = seconds > 0.0 ? static_cast<double>(result.tasks) / seconds : 0.0;
+		result.queue_wait = detail::summarize(waits);
+		result.end_to_end = detail::summarize(latencies);
+		return result;
+	}
+}
+
+#endif //THREAD_POOL_TRACE_WORKLOAD_REPLAY_HPP
@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+#include <thread_pool/thread_pool.hpp>
+#include <thread_pool/batch_submitter.hpp>
+
+#include <future>
+#include <vector>
+
+
+using namespace thread_pool;
+
+TEST(BatchSubmitterTest, results_fan_out_to_futures)
+{
+	ThreadPool<> thread_pool(2);
+	BatchSubmitter submitter(thread_pool, BatchOptions{.min_batch = 16, .max_batch = 16});
+
+	std::vector<std::future<int>> results;
+	for(int i = 0; i < 1000; ++i)
+	{
+		results.push_back(submitter.submit([](int x){ return x * 3; }, i));
+	}
+	auto failing = submitter.submit([]() -> int { throw std::runtime_error("failed"); });
+	submitter.flush();
+
+	for(int i = 0; i < 1000; ++i)
+	{
+		ASSERT_EQ(i * 3, results[i].get());
+	}
+	ASSERT_THROW(failing.get(), std::runtime_error);
+}
+
+TEST(BatchSubmitterTest, default_time_budget_flushes_open_batch)
+{
+	ThreadPool<> thread_pool(1);
+	BatchSubmitter submitter(thread_pool, BatchOptions{.min_batch = 4, .max_batch = 4});
+
+	for(int i = 0; i < 3; ++i)
+	{
+		auto task = submitter.submit([i](){ return i; });
+		ASSERT_EQ(std::future_status::ready, task.wait_for(std::chrono::seconds(5)));
+		ASSERT_EQ(i, task.get());
+	}
+}
+
+TEST(BatchSubmitterTest, time_budget_flushes_open_batch)
+{
+	ThreadPool<> thread_pool(1);
+	BatchSubmitter submitter(
+			thread_pool,
+			BatchOptions{.min_batch = 100, .max_batch = 100, .max_delay = std::chrono::milliseconds(1)}
+	);
+
+	auto task = submitter.submit([](){ return 5; });
+	ASSERT_EQ(std::future_status::ready, task.wait_for(std::chrono::seconds(5)));
+	ASSERT_EQ(5, task.get());
+}
+
+TEST(BatchSubmitterTest, batch_size_follows_task_time)
+{
+	ThreadPool<> thread_pool(1);
+	const BatchOptions options{
+		.min_batch = 1,
+		.max_batch = 64,
+		.max_delay = std::chrono::nanoseconds(0),
+		.target_chunk_time = std::chrono::microseconds(500)
+	};
+
+	{
+		BatchSubmitter submitter(thread_pool, options);
+		for(int round = 0; round < 10 && submitter.batch_size() < options.max_batch; ++round)
+		{
+			std::vector<std::future<int>> results;
+			for(int i = 0; i < 100; ++i)
+			{
+				results.push_back(submitter.submit([](int x){ return x + 1; }, i));
+			}
+			submitter.flush();
+			for(auto& result: results)
+			{
+				result.get();
+			}
+		}
+		ASSERT_EQ(options.max_batch, submitter.batch_size());
+	}
+
+	{
+		BatchSubmitter submitter(thread_pool, BatchOptions{.min_batch = 1, .max_batch = 64, .max_delay = {}});
+		for(int i = 0; i < 5; ++i)
+		{
+			submitter.submit([](){ std::this_thread::sleep_for(std::chrono::milliseconds(2)); }).get();
+		}
+		submitter.submit([](){}).get();
+		ASSERT_GE(submitter.average_task_time(), std::chrono::milliseconds(1));
+		ASSERT_EQ(1, submitter.batch_size());
+	}
+}
@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+#include <thread_pool/channel.hpp>
+
+#include <atomic>
+#include <future>
+#include <string>
+#include <thread>
+
+
+using namespace thread_pool;
+
+TEST(ChannelTest, send_receive_and_close)
+{
+	Channel<int> channel(2);
+
+	ASSERT_EQ(QueueOpStatus::success, channel.send(1));
+	ASSERT_EQ(QueueOpStatus::success, channel.send(2));
+	ASSERT_EQ(QueueOpStatus::full, channel.try_send(3));
+
+	channel.close();
+	ASSERT_EQ(QueueOpStatus::closed, channel.send(4));
+
+	int value = 0;
+	ASSERT_EQ(QueueOpStatus::success, channel.receive(value));
+	ASSERT_EQ(1, value);
+	ASSERT_EQ(QueueOpStatus::success, channel.try_receive(value));
+	ASSERT_EQ(2, value);
+	ASSERT_EQ(QueueOpStatus::closed, channel.receive(value));
+}
+
+TEST(ChannelTest, select_returns_ready_channel)
+{
+	Channel<std::string> bounded(4);
+	UnboundedChannel<std::string> unbounded;
+
+	std::string value;
+	ASSERT_EQ(
+			QueueOpStatus::timeout,
+			select_until(std::chrono::steady_clock::now() + std::chrono::milliseconds(10), value, bounded, unbounded).status
+	);
+
+	auto sender = std::async(std::launch::async, [&](){
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		static_cast<void>(unbounded.send("late"));
+	});
+
+	SelectResult result = select(value, bounded, unbounded);
+	sender.get();
+	ASSERT_EQ(QueueOpStatus::success, result.status);
+	ASSERT_EQ(1, result.index);
+	ASSERT_EQ("late", value);
+
+	ASSERT_EQ(QueueOpStatus::success, bounded.send("first"));
+	result = select(value, bounded, unbounded);
+	ASSERT_EQ(0, result.index);
+	ASSERT_EQ("first", value);
+
+	bounded.close();
+	unbounded.close();
+	ASSERT_EQ(QueueOpStatus::closed, select(value, bounded, unbounded).status);
+}
+
+TEST(ChannelTest, select_from_many_producers)
+{
+	constexpr int per_producer = 1000;
+	Channel<int> channel_1(8);
+	Channel<int> channel_2(8);
+
+	auto producer = [per_producer](Channel<int>& channel){
+		for(int i = 1; i <= per_producer; ++i)
+		{
+			static_cast<void>(channel.send(i));
+		}
+		channel.close();
+	};
+	std::thread producer_1(producer, std::ref(channel_1));
+	std::thread producer_2(producer, std::ref(channel_2));
+
+	long long sum = 0;
+	int value = 0;
+	while(select(value, channel_1, channel_2).status == QueueOpStatus::success)
+	{
+		sum += value;
+	}
+	producer_1.join();
+	producer_2.join();
+
+	ASSERT_EQ(2LL * per_producer * (per_producer + 1) / 2, sum);
+}
+
+TEST(ChannelTest, rendezvous_waits_for_receiver)
+{
+	Channel<int> channel(0);
+	ASSERT_TRUE(channel.rendezvous());
+	ASSERT_EQ(QueueOpStatus::full, channel.try_send(1));
+
+	std::atomic<bool> sent = false;
+	auto sender = std::async(std::launch::async, [&](){
+		auto status = channel.send(7);
+		sent = true;
+		return status;
+	});
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	ASSERT_FALSE(sent.load());
+
+	int value = 0;
+	ASSERT_EQ(QueueOpStatus::success, channel.receive(value));
+	ASSERT_EQ(7, value);
+	ASSERT_EQ(QueueOpStatus::success, sender.get());
+	ASSERT_TRUE(sent.load());
+}
@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+#include <thread_pool/thread_pool.hpp>
+#include <thread_pool/trace/chrome_tracer.hpp>
+
+#include <sstream>
+#include <string>
+
+
+using namespace thread_pool;
+
+namespace
+{
+	struct TracedPolicy: DefaultPolicy
+	{
+		using metrics = ChromeTracer;
+	};
+
+	std::size_t count_occurrences(const std::string& text, const std::string& pattern)
+	{
+		std::size_t count = 0;
+		for(auto pos = text.find(pattern); pos != std::string::npos; pos = text.find(pattern, pos + 1))
+		{
+			++count;
+		}
+		return count;
+	}
+}
+
+TEST(ChromeTracerTest, records_labeled_tasks)
+{
+	ThreadPool<NaiveBlockingQueue, TracedPolicy> thread_pool(2);
+
+	auto task_1 = thread_pool.enqueue(TaskLabel("parse"), [](){ return 1; });
+	auto task_2 = thread_pool.enqueue(TaskLabel("say \"hi\""), [](int x){ return x; }, 2);
+	auto task_3 = thread_pool.enqueue([](){ return 3; });
+
+	ASSERT_EQ(1, task_1.get());
+	ASSERT_EQ(2, task_2.get());
+	ASSERT_EQ(3, task_3.get());
+
+	// on_task_end runs right after the future is satisfied
+	std::string trace;
+	for(int attempt = 0; attempt < 100; ++attempt)
+	{
+		std::ostringstream out;
+		thread_pool.metrics().write_chrome_trace(out);
+		trace = out.str();
+		if(count_occurrences(trace, "\"ph\":\"X\"") == 3)
+		{
+			break;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	EXPECT_EQ(3, count_occurrences(trace, "\"ph\":\"X\""));
+	EXPECT_NE(std::string::npos, trace.find("\"name\":\"parse\""));
+	EXPECT_NE(std::string::npos, trace.find("\"name\":\"say \\\"hi\\\"\""));
+	EXPECT_NE(std::string::npos, trace.find("\"name\":\"task\""));
+	EXPECT_EQ(0, trace.find("{\"traceEvents\":["));
+	EXPECT_EQ(0, thread_pool.metrics().dropped());
+}
+
+TEST(ChromeTracerTest, ring_buffer_keeps_latest_events)
+{
+	ChromeTracer tracer(4, 2);
+
+	for(int i = 0; i < 10; ++i)
+	{
+		auto token = tracer.on_enqueue(TaskLabel("event"));
+		tracer.on_task_start(token, 1);
+		tracer.on_task_end(token, 1);
+	}
+
+	auto token = tracer.on_enqueue(TaskLabel("lost"));
+	tracer.on_task_end(token, 5);
+
+	std::ostringstream out;
+	tracer.write_chrome_trace(out);
+
+	EXPECT_EQ(4, count_occurrences(out.str(), "\"name\":\"event\""));
+	EXPECT_EQ(1, count_occurrences(out.str(), "\"tid\":1,\"args\""));
+	EXPECT_EQ(1, tracer.dropped());
+}
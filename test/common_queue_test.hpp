@@ -9,6 +9,7 @@
 #include <concepts>
 #include <array>
 #include <iterator>
+#include <chrono>
 
 
 template <typename Q>
@@ -169,6 +170,60 @@ TYPED_TEST_P(common_queue_test, multiple_try_push_pop)
 	ASSERT_TRUE(this->queue.empty());
 }
 
+TYPED_TEST_P(common_queue_test, wait_pop_for_timeout)
+{
+	int val;
+	ASSERT_EQ(
+		thread_pool::QueueOpStatus::timeout,
+		this->queue.wait_pop_for(val, std::chrono::milliseconds(5))
+	);
+	ASSERT_FALSE(this->queue.closed());
+}
+
+TYPED_TEST_P(common_queue_test, wait_pop_until)
+{
+	int val;
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(5);
+
+	ASSERT_EQ(thread_pool::QueueOpStatus::timeout, this->queue.wait_pop_until(val, deadline));
+
+	ASSERT_EQ(thread_pool::QueueOpStatus::success, this->queue.wait_push_until(4, deadline));
+	ASSERT_EQ(thread_pool::QueueOpStatus::success, this->queue.wait_pop_until(val, deadline));
+	ASSERT_EQ(4, val);
+}
+
+TYPED_TEST_P(common_queue_test, timed_ops_closed)
+{
+	this->queue.close();
+
+	int val;
+	ASSERT_EQ(
+		thread_pool::QueueOpStatus::closed,
+		this->queue.wait_pop_for(val, std::chrono::milliseconds(5))
+	);
+	ASSERT_EQ(
+		thread_pool::QueueOpStatus::closed,
+		this->queue.wait_push_for(1, std::chrono::milliseconds(5))
+	);
+}
+
+TYPED_TEST_P(common_queue_test, stats)
+{
+	if constexpr(requires { this->queue.stats(); })
+	{
+		push_container(this->queue, std::array<int, 3>{1, 2, 3});
+		static_cast<void>(this->queue.value_pop());
+
+		thread_pool::QueueStats stats = this->queue.stats();
+		ASSERT_EQ(2, stats.size);
+		ASSERT_EQ(3, stats.high_water_mark);
+		ASSERT_FALSE(stats.closed);
+
+		this->queue.close();
+		ASSERT_TRUE(this->queue.stats().closed);
+	}
+}
+
 REGISTER_TYPED_TEST_SUITE_P(
 	common_queue_test,
 	initial_setup,
@@ -179,7 +234,11 @@ REGISTER_TYPED_TEST_SUITE_P(
 	try_push_pop,
 	try_pop_empty,
 	try_pop_closed,
-	multiple_try_push_pop
+	multiple_try_push_pop,
+	wait_pop_for_timeout,
+	wait_pop_until,
+	timed_ops_closed,
+	stats
 );
 
 #endif //THREAD_POOL_COMMON_QUEUE_TEST_HPP
\ No newline at end of file
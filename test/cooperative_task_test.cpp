@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+#include <thread_pool/thread_pool.hpp>
+#include <thread_pool/cooperative_task.hpp>
+#include <thread_pool/trace/chrome_tracer.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#ifdef THREAD_POOL_COOPERATIVE_TASKS
+
+using namespace thread_pool;
+
+TEST(CooperativeTaskTest, returns_value_across_yields)
+{
+	ThreadPool thread_pool(2);
+
+	auto sum = thread_pool.enqueue_cooperative([](int count) -> CooperativeTask<int>
+	{
+		int result = 0;
+		for(int i = 1; i <= count; ++i)
+		{
+			result += i;
+			co_await this_task::yield();
+		}
+		co_return result;
+	}, 100);
+	ASSERT_EQ(5050, sum.get());
+
+	// captures of the coroutine lambda live as long as its frame
+	auto text = thread_pool.enqueue_cooperative([prefix = std::string("yielded ")]() -> CooperativeTask<std::string>
+	{
+		co_await this_task::yield();
+		co_return prefix + "twice";
+	});
+	ASSERT_EQ("yielded twice", text.get());
+}
+
+TEST(CooperativeTaskTest, short_tasks_run_between_slices)
+{
+	ThreadPool thread_pool(1);
+
+	std::atomic<bool> short_done = false;
+	auto long_task = thread_pool.enqueue_cooperative([&short_done]() -> CooperativeTask<int>
+	{
+		int slices = 1;
+		const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+		while(!short_done.load() && std::chrono::steady_clock::now() < deadline)
+		{
+			co_await this_task::yield();
+			++slices;
+		}
+		co_return slices;
+	});
+	auto short_task = thread_pool.enqueue([&short_done](){ short_done = true; });
+
+	short_task.get();
+	ASSERT_GT(long_task.get(), 1);
+	ASSERT_TRUE(short_done.load());
+}
+
+TEST(CooperativeTaskTest, maybe_yield_and_errors)
+{
+	ThreadPool thread_pool(2);
+
+	auto failing = thread_pool.enqueue_cooperative([]() -> CooperativeTask<>
+	{
+		co_await this_task::maybe_yield(std::chrono::hours(1));
+		co_await this_task::maybe_yield(std::chrono::nanoseconds(0));
+		throw std::runtime_error("cooperative failure");
+	});
+	ASSERT_THROW(failing.get(), std::runtime_error);
+}
+
+TEST(CooperativeTaskTest, unsubmitted_task_is_destroyed)
+{
+	auto alive = std::make_shared<int>(0);
+	{
+		auto coroutine = [](std::shared_ptr<int> value) -> CooperativeTask<>
+		{
+			++*value;
+			co_return;
+		};
+		auto task = coroutine(alive);
+		ASSERT_EQ(2, alive.use_count());
+	}
+	ASSERT_EQ(1, alive.use_count());
+	ASSERT_EQ(0, *alive);
+}
+
+TEST(CooperativeTaskTest, traced_slices)
+{
+	struct TracedPolicy: DefaultPolicy
+	{
+		using metrics = ChromeTracer;
+	};
+	ThreadPool<NaiveBlockingQueue, TracedPolicy> thread_pool(2);
+
+	auto task = thread_pool.enqueue_cooperative([]() -> CooperativeTask<int>
+	{
+		co_await this_task::yield();
+		co_await this_task::yield();
+		co_return 3;
+	});
+	ASSERT_EQ(3, task.get());
+}
+
+#endif
@@ -0,0 +1,119 @@
+#if defined(__linux__)
+
+#include <gtest/gtest.h>
+#include <thread_pool/thread_pool.hpp>
+#include <thread_pool/io/epoll_reactor.hpp>
+
+#include <sys/socket.h>
+
+#include <array>
+#include <future>
+#include <string>
+
+
+using namespace thread_pool;
+
+namespace
+{
+	class EpollReactorTest: public testing::Test
+	{
+	protected:
+		EpollReactorTest()
+		{
+			EXPECT_EQ(0, ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds_));
+		}
+
+		~EpollReactorTest() override
+		{
+			::close(fds_[0]);
+			::close(fds_[1]);
+		}
+
+		int fds_[2] = {-1, -1};
+		ThreadPool<> thread_pool_{2};
+	};
+}
+
+TEST_F(EpollReactorTest, read_completes_after_write)
+{
+	EpollReactor reactor(thread_pool_);
+
+	std::array<char, 16> buffer{};
+	std::promise<IoResult> read_done;
+	reactor.async_read(
+			fds_[0],
+			buffer.data(),
+			buffer.size(),
+			[&read_done](const IoResult& result) { read_done.set_value(result); }
+	);
+
+	auto read_future = read_done.get_future();
+	EXPECT_EQ(std::future_status::timeout, read_future.wait_for(std::chrono::milliseconds(10)));
+
+	const std::string message = "ping";
+	std::promise<IoResult> write_done;
+	reactor.async_write(
+			fds_[1],
+			message.data(),
+			message.size(),
+			[&write_done](const IoResult& result) { write_done.set_value(result); }
+	);
+
+	const auto write_result = write_done.get_future().get();
+	EXPECT_FALSE(write_result.error);
+	EXPECT_EQ(message.size(), write_result.bytes);
+
+	const auto read_result = read_future.get();
+	ASSERT_FALSE(read_result.error);
+	ASSERT_EQ(message.size(), read_result.bytes);
+	EXPECT_EQ(message, std::string(buffer.data(), read_result.bytes));
+}
+
+TEST_F(EpollReactorTest, many_pending_reads)
+{
+	EpollReactor reactor(thread_pool_);
+
+	constexpr int reads = 100;
+	std::array<char, reads> buffer{};
+	std::atomic<int> completed = 0;
+	std::promise<void> all_done;
+
+	for(int i = 0; i < reads; ++i)
+	{
+		reactor.async_read(
+				fds_[0],
+				&buffer[i],
+				1,
+				[&](const IoResult& result)
+				{
+					EXPECT_EQ(1, result.bytes);
+					if(++completed == reads)
+					{
+						all_done.set_value();
+					}
+				}
+		);
+	}
+
+	std::array<char, reads> data;
+	data.fill('x');
+	ASSERT_EQ(reads, ::write(fds_[1], data.data(), data.size()));
+
+	ASSERT_EQ(std::future_status::ready, all_done.get_future().wait_for(std::chrono::seconds(5)));
+	EXPECT_EQ(data, buffer);
+}
+
+TEST_F(EpollReactorTest, cancel_pending)
+{
+	EpollReactor reactor(thread_pool_);
+
+	char byte;
+	std::promise<IoResult> read_done;
+	reactor.async_read(fds_[0], &byte, 1, [&read_done](const IoResult& result) { read_done.set_value(result); });
+	reactor.cancel(fds_[0]);
+
+	const auto result = read_done.get_future().get();
+	EXPECT_EQ(std::make_error_code(std::errc::operation_canceled), result.error);
+}
+
+#endif
@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+#include <thread_pool/queue/event_count.hpp>
+#include <thread_pool/queue/ring_blocking_queue.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+
+using namespace thread_pool;
+
+TEST(EventCountTest, notify_wakes_committed_waiter)
+{
+	EventCount event_count;
+	std::atomic<bool> ready = false;
+
+	std::thread waiter([&](){
+		while(!ready.load())
+		{
+			auto key = event_count.prepare_wait();
+			if(ready.load())
+			{
+				event_count.cancel_wait();
+				break;
+			}
+			event_count.commit_wait(key);
+		}
+	});
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	ready = true;
+	event_count.notify_one();
+	waiter.join();
+}
+
+TEST(EventCountTest, commit_wait_until_times_out)
+{
+	EventCount event_count;
+
+	auto key = event_count.prepare_wait();
+	const auto start = std::chrono::steady_clock::now();
+	ASSERT_FALSE(event_count.commit_wait_until(key, start + std::chrono::milliseconds(20)));
+	ASSERT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(20));
+
+	// a notification between prepare and commit is not lost
+	key = event_count.prepare_wait();
+	event_count.notify_one();
+	ASSERT_TRUE(event_count.commit_wait_until(key, std::chrono::steady_clock::now() + std::chrono::seconds(5)));
+}
+
+TEST(EventCountTest, close_wakes_all_waiters)
+{
+	constexpr std::size_t waiter_count = 200;
+	EventCountRingBlockingQueue<int> queue(4);
+
+	std::atomic<std::size_t> closed = 0;
+	std::vector<std::thread> waiters;
+	for(std::size_t i = 0; i < waiter_count; ++i)
+	{
+		waiters.emplace_back([&](){
+			int value;
+			if(queue.wait_pop(value) == QueueOpStatus::closed)
+			{
+				++closed;
+			}
+		});
+	}
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	queue.close();
+	for(auto& waiter: waiters)
+	{
+		waiter.join();
+	}
+	ASSERT_EQ(waiter_count, closed.load());
+}
+
+TEST(EventCountTest, notify_all_wakes_old_waiters_while_new_ones_arrive)
+{
+	constexpr std::size_t waiter_count = 16;
+	EventCount event_count;
+
+	std::atomic<std::size_t> registered = 0;
+	std::atomic<std::size_t> woken = 0;
+	std::vector<std::thread> old_waiters;
+	for(std::size_t i = 0; i < waiter_count; ++i)
+	{
+		old_waiters.emplace_back([&](){
+			auto key = event_count.prepare_wait();
+			++registered;
+			event_count.commit_wait(key);
+			++woken;
+		});
+	}
+	while(registered.load() != waiter_count)
+	{
+		std::this_thread::yield();
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+	// sleepers of the new epoch compete for the wakeups meant for the old one
+	std::atomic<bool> stopping = false;
+	std::vector<std::thread> new_waiters;
+	for(std::size_t i = 0; i < waiter_count; ++i)
+	{
+		new_waiters.emplace_back([&](){
+			while(!stopping.load())
+			{
+				auto key = event_count.prepare_wait();
+				if(stopping.load())
+				{
+					event_count.cancel_wait();
+					break;
+				}
+				event_count.commit_wait(key);
+			}
+		});
+	}
+
+	event_count.notify_all();
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while(woken.load() != waiter_count && std::chrono::steady_clock::now() < deadline)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	EXPECT_EQ(waiter_count, woken.load());
+
+	stopping = true;
+	event_count.notify_all();
+	for(auto& waiter: new_waiters)
+	{
+		waiter.join();
+	}
+	// releases old waiters a failed expectation left sleeping
+	event_count.notify_all();
+	for(auto& waiter: old_waiters)
+	{
+		waiter.join();
+	}
+}
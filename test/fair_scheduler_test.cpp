@@ -0,0 +1,218 @@
+#include <gtest/gtest.h>
+#include <thread_pool/thread_pool.hpp>
+#include <thread_pool/fair_scheduler.hpp>
+
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <vector>
+
+
+using namespace thread_pool;
+
+TEST(FairSchedulerTest, results)
+{
+	ThreadPool<> thread_pool(2);
+	FairScheduler scheduler(thread_pool);
+
+	const auto channel = scheduler.add_channel("default");
+	auto task_1 = scheduler.submit(channel, [](int x){ return x * 3; }, 3);
+	auto task_2 = scheduler.submit(channel, [](){ return std::string("test"); });
+
+	ASSERT_EQ(9, task_1.get());
+	ASSERT_EQ("test", task_2.get());
+}
+
+TEST(FairSchedulerTest, flooding_channel_does_not_starve_others)
+{
+	ThreadPool<> thread_pool(1);
+	FairScheduler scheduler(thread_pool, 1);
+
+	const auto noisy = scheduler.add_channel("noisy");
+	const auto quiet = scheduler.add_channel("quiet", ChannelOptions{.weight = 1});
+
+	std::promise<void> release;
+	auto gate = release.get_future().share();
+
+	std::mutex order_mutex;
+	std::vector<char> order;
+	auto record = [&](char source)
+	{
+		std::scoped_lock lock(order_mutex);
+		order.push_back(source);
+	};
+
+	auto blocker = scheduler.submit(noisy, [gate](){ gate.wait(); });
+	for(int i = 0; i < 10; ++i)
+	{
+		static_cast<void>(scheduler.submit(noisy, [&record](){ record('n'); }));
+	}
+	auto quiet_task = scheduler.submit(quiet, [&record](){ record('q'); });
+
+	release.set_value();
+	quiet_task.get();
+	blocker.get();
+
+	std::scoped_lock lock(order_mutex);
+	ASSERT_FALSE(order.empty());
+	EXPECT_LE(std::find(order.begin(), order.end(), 'q') - order.begin(), 1);
+}
+
+TEST(FairSchedulerTest, weights)
+{
+	ThreadPool<> thread_pool(1);
+	FairScheduler scheduler(thread_pool, 1);
+
+	const auto heavy = scheduler.add_channel("heavy", ChannelOptions{.weight = 3});
+	const auto light = scheduler.add_channel("light", ChannelOptions{.weight = 1});
+
+	std::promise<void> release;
+	auto gate = release.get_future().share();
+
+	std::mutex order_mutex;
+	std::vector<char> order;
+
+	auto blocker = scheduler.submit(light, [gate](){ gate.wait(); });
+	for(int i = 0; i < 6; ++i)
+	{
+		static_cast<void>(scheduler.submit(heavy, [&](){ std::scoped_lock lock(order_mutex); order.push_back('h'); }));
+		static_cast<void>(scheduler.submit(light, [&](){ std::scoped_lock lock(order_mutex); order.push_back('l'); }));
+	}
+
+	release.set_value();
+	blocker.get();
+	auto last = scheduler.submit(light, [](){});
+	last.get();
+	while(scheduler.stats()[0].completed != 6)
+	{
+		std::this_thread::yield();
+	}
+
+	std::scoped_lock lock(order_mutex);
+	ASSERT_EQ(12, order.size());
+	EXPECT_EQ(std::vector<char>({'h', 'h', 'h', 'l', 'h', 'h', 'h', 'l'}), std::vector<char>(order.begin(), order.begin() + 8));
+}
+
+TEST(FairSchedulerTest, depth_limit_and_stats)
+{
+	ThreadPool<> thread_pool(1);
+	FairScheduler scheduler(thread_pool, 1);
+
+	const auto channel = scheduler.add_channel("limited", ChannelOptions{.weight = 1, .max_concurrency = 1, .max_depth = 2});
+
+	std::promise<void> release;
+	auto gate = release.get_future().share();
+
+	auto running = scheduler.submit(channel, [gate](){ gate.wait(); });
+	auto queued_1 = scheduler.submit(channel, [](){});
+	auto queued_2 = scheduler.submit(channel, [](){});
+	EXPECT_THROW(static_cast<void>(scheduler.submit(channel, [](){})), ChannelFullException);
+
+	const auto stats = scheduler.stats();
+	ASSERT_EQ(1, stats.size());
+	EXPECT_EQ("limited", stats[0].name);
+	EXPECT_EQ(2, stats[0].queued);
+	EXPECT_EQ(1, stats[0].running);
+	EXPECT_EQ(3, stats[0].submitted);
+	EXPECT_EQ(1, stats[0].rejected);
+
+	release.set_value();
+	queued_2.get();
+}
+
+TEST(FairSchedulerTest, concurrency_cap)
+{
+	ThreadPool<> thread_pool(4);
+	FairScheduler scheduler(thread_pool);
+
+	const auto channel = scheduler.add_channel("capped", ChannelOptions{.weight = 1, .max_concurrency = 2});
+
+	std::atomic<int> running = 0;
+	std::atomic<int> max_running = 0;
+	std::vector<std::future<void>> tasks;
+	for(int i = 0; i < 20; ++i)
+	{
+		tasks.push_back(
+				scheduler.submit(
+						channel,
+						[&]()
+						{
+							const int now = ++running;
+							int expected = max_running.load();
+							while(now > expected && !max_running.compare_exchange_weak(expected, now)) {}
+							std::this_thread::sleep_for(std::chrono::microseconds(200));
+							--running;
+						}
+				)
+		);
+	}
+	for(auto& task: tasks)
+	{
+		task.get();
+	}
+	EXPECT_LE(max_running.load(), 2);
+}
+
+namespace
+{
+	// pool which refuses new tasks after shutdown(), like a ThreadPool whose queues are closed
+	class ClosablePool
+	{
+	public:
+		explicit ClosablePool(std::size_t thread_count)
+		:
+			pool_(thread_count)
+		{}
+
+		template<typename F>
+		auto enqueue(F&& fun)
+		{
+			if(closed_)
+			{
+				throw QueueClosedException();
+			}
+			return pool_.enqueue(std::forward<F>(fun));
+		}
+
+		[[nodiscard]] std::size_t thread_count() const noexcept
+		{
+			return pool_.thread_count();
+		}
+
+		void shutdown() noexcept
+		{
+			closed_ = true;
+		}
+
+	private:
+		ThreadPool<> pool_;
+		std::atomic<bool> closed_ = false;
+	};
+}
+
+TEST(FairSchedulerTest, pool_shut_down)
+{
+	ClosablePool pool(1);
+	std::future<void> queued;
+	std::future<int> refused;
+	{
+		FairScheduler scheduler(pool, 1);
+		const auto channel = scheduler.add_channel("default");
+
+		std::promise<void> release;
+		auto gate = release.get_future().share();
+
+		auto running = scheduler.submit(channel, [gate](){ gate.wait(); });
+		queued = scheduler.submit(channel, [](){});
+
+		pool.shutdown();
+		refused = scheduler.submit(channel, [](){ return 1; });
+
+		release.set_value();
+		running.get();
+		// destructor returns although the pool dropped the queued tasks
+	}
+
+	EXPECT_THROW(queued.get(), std::future_error);
+	EXPECT_THROW(refused.get(), std::future_error);
+}
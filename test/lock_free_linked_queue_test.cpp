@@ -0,0 +1,82 @@
+#include "thread_pool/queue/lock_free_linked_queue.hpp"
+#include "common_queue_test.hpp"
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+
+using namespace thread_pool;
+
+template <>
+LockFreeLinkedQueue<int> createQueue(size_t)
+{
+	return {};
+}
+
+using LockFreeLinkedQueueImplementation = testing::Types<LockFreeLinkedQueue<int>>;
+
+INSTANTIATE_TYPED_TEST_SUITE_P(
+	LockFreeLinkedQueueCommonTest,
+	common_queue_test,
+	LockFreeLinkedQueueImplementation,
+);
+
+TEST(LockFreeLinkedQueueTest, spans_blocks_and_recycles_them)
+{
+	LockFreeLinkedQueue<std::unique_ptr<int>> queue;
+	constexpr int count = 10 * LockFreeLinkedQueue<int>::block_capacity;
+
+	for(int round = 0; round < 3; ++round)
+	{
+		for(int i = 0; i < count; ++i)
+		{
+			queue.push(std::make_unique<int>(i));
+		}
+		ASSERT_EQ(count, queue.size());
+
+		for(int i = 0; i < count; ++i)
+		{
+			ASSERT_EQ(i, *queue.value_pop());
+		}
+		ASSERT_TRUE(queue.empty());
+	}
+
+	// blocks drained in later rounds come from the spare slots
+	ASSERT_LE(queue.allocated_blocks(), 12 + LockFreeLinkedQueue<int>::spare_blocks);
+
+	// remaining elements are destroyed with the queue
+	queue.push(std::make_unique<int>(1));
+	queue.close();
+}
+
+TEST(LockFreeLinkedQueueTest, parked_consumers_wake_up)
+{
+	LockFreeLinkedQueue<int> queue;
+
+	std::vector<std::thread> consumers;
+	std::atomic<int> sum = 0;
+	for(int i = 0; i < 4; ++i)
+	{
+		consumers.emplace_back([&](){
+			int value;
+			while(queue.wait_pop(value) == QueueOpStatus::success)
+			{
+				sum += value;
+			}
+		});
+	}
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	for(int i = 1; i <= 100; ++i)
+	{
+		queue.push(i);
+	}
+	queue.close();
+
+	for(auto& consumer: consumers)
+	{
+		consumer.join();
+	}
+	ASSERT_EQ(5050, sum.load());
+}
@@ -10,7 +10,13 @@ NaiveBlockingQueue<int> createQueue(size_t)
 	return {};
 }
 
-using NaiveBlockingQueueImplementation = testing::Types<NaiveBlockingQueue<int>>;
+template <>
+EventCountNaiveBlockingQueue<int> createQueue(size_t)
+{
+	return {};
+}
+
+using NaiveBlockingQueueImplementation = testing::Types<NaiveBlockingQueue<int>, EventCountNaiveBlockingQueue<int>>;
 
 INSTANTIATE_TYPED_TEST_SUITE_P(
 	NaiveBlockingQueueCommonTest,
@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+#include <thread_pool/posix_thread_factory.hpp>
+#include <thread_pool/thread_pool.hpp>
+
+#include <string>
+#include <system_error>
+
+#if defined(__unix__) || defined(__APPLE__)
+
+namespace
+{
+	struct PosixPolicy: thread_pool::DefaultPolicy
+	{
+		using thread_factory = thread_pool::PosixThreadFactory;
+	};
+
+	using PosixPool = thread_pool::ThreadPool<thread_pool::NaiveBlockingQueue, PosixPolicy>;
+
+	std::string current_thread_name()
+	{
+		char name[16] = {};
+		pthread_getname_np(pthread_self(), name, sizeof(name));
+		return name;
+	}
+}
+
+TEST(PosixThreadFactoryTest, names_and_stack_size)
+{
+	thread_pool::ThreadAttributes attributes;
+	attributes.stack_size = 256 * 1024;
+	attributes.name_pattern = "tp-worker-{}";
+
+	PosixPool thread_pool(thread_pool::PosixThreadFactory(attributes), 2, 2);
+
+	const std::string name = thread_pool.enqueue(current_thread_name).get();
+	ASSERT_TRUE(name == "tp-worker-0" || name == "tp-worker-1") << name;
+
+#if defined(__linux__)
+	auto stack_size = thread_pool.enqueue([](){
+		pthread_attr_t attr;
+		pthread_getattr_np(pthread_self(), &attr);
+		std::size_t size = 0;
+		pthread_attr_getstacksize(&attr, &size);
+		pthread_attr_destroy(&attr);
+		return size;
+	});
+	ASSERT_EQ(256 * 1024, stack_size.get());
+#endif
+}
+
+#if defined(__linux__)
+TEST(PosixThreadFactoryTest, nice_value)
+{
+	thread_pool::ThreadAttributes attributes;
+	attributes.nice = 5;
+
+	PosixPool thread_pool(thread_pool::PosixThreadFactory(attributes), 1, 1);
+
+	auto nice = thread_pool.enqueue([](){
+		errno = 0;
+		return getpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)));
+	});
+	ASSERT_EQ(5, nice.get());
+}
+#endif
+
+TEST(PosixThreadFactoryTest, invalid_attributes_throw)
+{
+	thread_pool::ThreadAttributes attributes;
+	attributes.sched_policy = SCHED_FIFO;
+	attributes.sched_priority = 10000;
+
+	thread_pool::PosixThreadFactory factory(attributes);
+	ASSERT_THROW(static_cast<void>(factory.create(0, [](){})), std::system_error);
+}
+
+TEST(PosixThreadFactoryTest, thread_name_pattern)
+{
+	thread_pool::ThreadAttributes attributes;
+	attributes.name_pattern = "io-{}";
+	thread_pool::PosixThreadFactory factory(attributes);
+
+	ASSERT_EQ("io-12", factory.thread_name(12));
+	ASSERT_EQ("", thread_pool::PosixThreadFactory().thread_name(3));
+}
+
+#endif
@@ -13,7 +13,13 @@ QueueType createQueue(size_t size)
 	return QueueType(size);
 }
 
-using RingBlockingQueueImplementation = testing::Types<QueueType>;
+template <>
+EventCountRingBlockingQueue<int> createQueue(size_t size)
+{
+	return EventCountRingBlockingQueue<int>(size);
+}
+
+using RingBlockingQueueImplementation = testing::Types<QueueType, EventCountRingBlockingQueue<int>>;
 
 INSTANTIATE_TYPED_TEST_SUITE_P(
 	RingBlockingQueueCommonTest,
@@ -25,4 +31,116 @@ INSTANTIATE_TYPED_TEST_SUITE_P(
 	RingBlockingQueueSizedTest,
 	sized_queue_test,
 	RingBlockingQueueImplementation,
-);
\ No newline at end of file
+);
+
+namespace
+{
+	struct NoDefault
+	{
+		explicit NoDefault(int val)
+		:
+			value(val)
+		{}
+
+		int value;
+	};
+
+	struct ThrowingMove
+	{
+		static inline bool throw_on_move = false;
+
+		explicit ThrowingMove(int val)
+		:
+			value(val)
+		{}
+
+		ThrowingMove(const ThrowingMove&) = default;
+		ThrowingMove& operator=(const ThrowingMove&) = default;
+
+		ThrowingMove(ThrowingMove&& other)
+		:
+			value(other.value)
+		{
+			if(throw_on_move)
+			{
+				throw std::runtime_error("move");
+			}
+		}
+
+		ThrowingMove& operator=(ThrowingMove&& other)
+		{
+			if(throw_on_move)
+			{
+				throw std::runtime_error("move");
+			}
+			value = other.value;
+			return *this;
+		}
+
+		int value;
+	};
+}
+
+TEST(RingBlockingQueueTest, non_default_constructible)
+{
+	RingBlockingQueue<NoDefault> queue(2);
+
+	queue.push(NoDefault(4));
+	ASSERT_EQ(QueueOpStatus::success, queue.try_push(NoDefault(5)));
+
+	ASSERT_EQ(4, queue.value_pop().value);
+
+	NoDefault dest(0);
+	ASSERT_EQ(QueueOpStatus::success, queue.try_pop(dest));
+	ASSERT_EQ(5, dest.value);
+}
+
+TEST(RingBlockingQueueTest, throwing_push_keeps_queue_open)
+{
+	RingBlockingQueue<ThrowingMove> queue(2);
+
+	ThrowingMove::throw_on_move = true;
+	EXPECT_THROW(static_cast<void>(queue.try_push(ThrowingMove(1))), std::runtime_error);
+	ThrowingMove::throw_on_move = false;
+
+	EXPECT_FALSE(queue.closed());
+	EXPECT_TRUE(queue.empty());
+
+	queue.push(ThrowingMove(2));
+	EXPECT_EQ(2, queue.value_pop().value);
+}
+
+TEST(RingBlockingQueueTest, throwing_pop_keeps_element)
+{
+	RingBlockingQueue<ThrowingMove> queue(2);
+	queue.push(ThrowingMove(3));
+
+	ThrowingMove dest(0);
+	ThrowingMove::throw_on_move = true;
+	EXPECT_THROW(static_cast<void>(queue.try_pop(dest)), std::runtime_error);
+	EXPECT_THROW(static_cast<void>(queue.wait_pop(dest)), std::runtime_error);
+	ThrowingMove::throw_on_move = false;
+
+	EXPECT_FALSE(queue.closed());
+	ASSERT_FALSE(queue.empty());
+	ASSERT_EQ(QueueOpStatus::success, queue.try_pop(dest));
+	EXPECT_EQ(3, dest.value);
+}
+
+TEST(RingBlockingQueueTest, reserve_keeps_elements)
+{
+	RingBlockingQueue<int> queue(8);
+	for(int i = 0; i < 6; ++i)
+	{
+		queue.push(i);
+	}
+	for(int i = 0; i < 4; ++i)
+	{
+		ASSERT_EQ(i, queue.value_pop());
+	}
+
+	queue.reserve(100);
+	ASSERT_EQ(4, queue.value_pop());
+	ASSERT_EQ(5, queue.value_pop());
+	ASSERT_TRUE(queue.empty());
+}
@@ -0,0 +1,111 @@
+#include "thread_pool/queue/segmented_ring_blocking_queue.hpp"
+#include "common_queue_test.hpp"
+#include "sized_queue_test.hpp"
+
+
+using namespace thread_pool;
+
+using QueueType = SegmentedRingBlockingQueue<int>;
+
+template <>
+QueueType createQueue(size_t size)
+{
+	return QueueType(size, 4);
+}
+
+using SegmentedRingBlockingQueueImplementation = testing::Types<QueueType>;
+
+INSTANTIATE_TYPED_TEST_SUITE_P(
+	SegmentedRingBlockingQueueCommonTest,
+	common_queue_test,
+	SegmentedRingBlockingQueueImplementation,
+);
+
+INSTANTIATE_TYPED_TEST_SUITE_P(
+	SegmentedRingBlockingQueueSizedTest,
+	sized_queue_test,
+	SegmentedRingBlockingQueueImplementation,
+);
+
+TEST(SegmentedRingBlockingQueueTest, lazy_allocation)
+{
+	QueueType queue(1000000, 16);
+
+	EXPECT_EQ(0, queue.allocated_segments());
+
+	queue.push(1);
+	EXPECT_EQ(1, queue.allocated_segments());
+
+	for(int i = 0; i < 40; ++i)
+	{
+		queue.push(i);
+	}
+	EXPECT_EQ(3, queue.allocated_segments());
+	EXPECT_EQ(41, queue.size());
+}
+
+TEST(SegmentedRingBlockingQueueTest, wrap_around_keeps_order)
+{
+	QueueType queue(10, 3);
+
+	for(int round = 0; round < 20; ++round)
+	{
+		for(int i = 0; i < 10; ++i)
+		{
+			ASSERT_EQ(QueueOpStatus::success, queue.try_push(round * 10 + i));
+		}
+		ASSERT_EQ(QueueOpStatus::full, queue.try_push(-1));
+
+		for(int i = 0; i < 10; ++i)
+		{
+			ASSERT_EQ(round * 10 + i, queue.value_pop());
+		}
+	}
+	EXPECT_TRUE(queue.empty());
+	EXPECT_LE(queue.allocated_segments(), 5);
+}
+
+TEST(SegmentedRingBlockingQueueTest, releases_idle_segments)
+{
+	QueueType queue(1000, 8);
+
+	for(int i = 0; i < 1000; ++i)
+	{
+		queue.push(i);
+	}
+	ASSERT_EQ(125, queue.allocated_segments());
+
+	int val;
+	for(int i = 0; i < 1000; ++i)
+	{
+		ASSERT_EQ(QueueOpStatus::success, queue.try_pop(val));
+	}
+
+	for(int i = 0; i < 100; ++i)
+	{
+		queue.push(i);
+		ASSERT_EQ(QueueOpStatus::success, queue.try_pop(val));
+	}
+	EXPECT_LE(queue.allocated_segments(), 2);
+}
+
+TEST(SegmentedRingBlockingQueueTest, reserve_preallocates_segments)
+{
+	QueueType queue(1000, 8);
+
+	queue.reserve(100);
+	ASSERT_EQ(13, queue.allocated_segments());
+
+	for(int i = 0; i < 100; ++i)
+	{
+		queue.push(i);
+	}
+	ASSERT_EQ(13, queue.allocated_segments());
+
+	queue.reserve(5000);
+	ASSERT_EQ(125, queue.allocated_segments());
+	for(int i = 0; i < 100; ++i)
+	{
+		ASSERT_EQ(i, queue.value_pop());
+	}
+}
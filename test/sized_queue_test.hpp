@@ -8,6 +8,7 @@
 #include "thread_pool/queue/common.hpp"
 #include <concepts>
 #include <iterator>
+#include <chrono>
 #include <thread_pool/queue/naive_blocking_queue.hpp>
 
 
@@ -84,12 +85,29 @@ TYPED_TEST_P(sized_queue_test, try_push_full)
 	EXPECT_EQ(thread_pool::QueueOpStatus::full, this->queue.try_push(8));
 }
 
+TYPED_TEST_P(sized_queue_test, wait_push_for_full)
+{
+	for(size_t i = 0; i < this->size; ++i)
+	{
+		this->queue.push(9);
+	}
+	ASSERT_TRUE(this->queue.full());
+
+	EXPECT_EQ(
+		thread_pool::QueueOpStatus::timeout,
+		this->queue.wait_push_for(8, std::chrono::milliseconds(5))
+	);
+	EXPECT_TRUE(this->queue.full());
+	EXPECT_FALSE(this->queue.closed());
+}
+
 REGISTER_TYPED_TEST_SUITE_P(
 	sized_queue_test,
 	invalid_initial_size,
 	capacity,
 	try_pop_empty,
-	try_push_full
+	try_push_full,
+	wait_push_for_full
 );
 
 #endif //THREAD_POOL_SIZED_QUEUE_TEST_HPP
@@ -0,0 +1,208 @@
+#include <gtest/gtest.h>
+#include <thread_pool/thread_pool.hpp>
+#include <thread_pool/strand.hpp>
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <vector>
+
+
+using namespace thread_pool;
+
+TEST(StrandTest, enqueue_result)
+{
+	ThreadPool<> thread_pool(2);
+	Strand strand(thread_pool);
+
+	auto task_1 = strand.enqueue([](int x){ return x + 1; }, 1);
+	auto task_2 = strand.enqueue([](){ return std::string("test"); });
+
+	ASSERT_EQ(2, task_1.get());
+	ASSERT_EQ("test", task_2.get());
+}
+
+TEST(StrandTest, fifo_order)
+{
+	ThreadPool<> thread_pool(4);
+	Strand strand(thread_pool);
+
+	std::vector<int> order;
+	std::vector<std::future<void>> tasks;
+	for(int i = 0; i < 500; ++i)
+	{
+		tasks.push_back(strand.enqueue([&order, i](){ order.push_back(i); }));
+	}
+	for(auto& task: tasks)
+	{
+		task.get();
+	}
+
+	ASSERT_EQ(500, order.size());
+	for(int i = 0; i < 500; ++i)
+	{
+		ASSERT_EQ(i, order[i]);
+	}
+}
+
+TEST(StrandTest, never_runs_concurrently)
+{
+	ThreadPool<> thread_pool(4);
+	Strand strand(thread_pool);
+
+	std::atomic<bool> inside = false;
+	std::atomic<bool> overlap = false;
+	int counter = 0;
+
+	std::vector<std::thread> producers;
+	for(int p = 0; p < 4; ++p)
+	{
+		producers.emplace_back(
+				[&]()
+				{
+					for(int i = 0; i < 250; ++i)
+					{
+						strand.post(
+								[&]()
+								{
+									if(inside.exchange(true))
+									{
+										overlap = true;
+									}
+									++counter;
+									inside = false;
+								}
+						);
+					}
+				}
+		);
+	}
+	for(auto& producer: producers)
+	{
+		producer.join();
+	}
+
+	strand.enqueue([](){}).get();
+	EXPECT_FALSE(overlap.load());
+	EXPECT_EQ(1000, counter);
+}
+
+TEST(StrandTest, many_strands)
+{
+	ThreadPool<> thread_pool(4);
+
+	std::vector<std::unique_ptr<Strand<ThreadPool<>>>> strands;
+	std::vector<int> counters(1000, 0);
+	for(std::size_t i = 0; i < counters.size(); ++i)
+	{
+		strands.push_back(std::make_unique<Strand<ThreadPool<>>>(thread_pool));
+	}
+
+	std::vector<std::future<void>> tasks;
+	for(int round = 0; round < 3; ++round)
+	{
+		for(std::size_t i = 0; i < strands.size(); ++i)
+		{
+			tasks.push_back(strands[i]->enqueue([&counters, i](){ ++counters[i]; }));
+		}
+	}
+	for(auto& task: tasks)
+	{
+		task.get();
+	}
+
+	for(int counter: counters)
+	{
+		ASSERT_EQ(3, counter);
+	}
+}
+
+TEST(StrandTest, pending_tasks_outlive_strand)
+{
+	ThreadPool<> thread_pool(1);
+
+	std::promise<void> release;
+	auto blocker = thread_pool.enqueue([gate = release.get_future()]() { gate.wait(); });
+
+	std::future<int> task;
+	{
+		Strand strand(thread_pool);
+		task = strand.enqueue([](){ return 5; });
+	}
+
+	release.set_value();
+	ASSERT_EQ(5, task.get());
+}
+
+namespace
+{
+	// pool whose try_post always reports a full queue and whose enqueue fails after shutdown()
+	class RefusingPool
+	{
+	public:
+		explicit RefusingPool(std::size_t thread_count)
+		:
+			pool_(thread_count)
+		{}
+
+		template<typename F>
+		auto enqueue(F&& fun)
+		{
+			if(closed_)
+			{
+				throw QueueClosedException();
+			}
+			return pool_.enqueue(std::forward<F>(fun));
+		}
+
+		template<typename F>
+		bool try_post(F&&)
+		{
+			return false;
+		}
+
+		void shutdown() noexcept
+		{
+			closed_ = true;
+		}
+
+	private:
+		ThreadPool<> pool_;
+		std::atomic<bool> closed_ = false;
+	};
+}
+
+TEST(StrandTest, drain_continues_when_pool_queue_is_full)
+{
+	RefusingPool pool(2);
+	Strand strand(pool);
+
+	std::vector<int> order;
+	std::vector<std::future<void>> tasks;
+	for(int i = 0; i < 3 * static_cast<int>(Strand<RefusingPool>::max_batch); ++i)
+	{
+		tasks.push_back(strand.enqueue([&order, i](){ order.push_back(i); }));
+	}
+	for(auto& task: tasks)
+	{
+		task.get();
+	}
+
+	ASSERT_EQ(3 * Strand<RefusingPool>::max_batch, order.size());
+	for(std::size_t i = 0; i < order.size(); ++i)
+	{
+		ASSERT_EQ(static_cast<int>(i), order[i]);
+	}
+}
+
+TEST(StrandTest, pool_shut_down)
+{
+	RefusingPool pool(1);
+	Strand strand(pool);
+	pool.shutdown();
+
+	// no worker takes the drain, the posting thread runs it
+	auto task = strand.enqueue([](){ return std::this_thread::get_id(); });
+	ASSERT_EQ(std::future_status::ready, task.wait_for(std::chrono::seconds(0)));
+	ASSERT_EQ(std::this_thread::get_id(), task.get());
+}
@@ -0,0 +1,362 @@
+#include <gtest/gtest.h>
+
+#include "thread_pool/detail/_queue_requirement.hpp"
+#include "thread_pool/queue/naive_blocking_queue.hpp"
+#include "thread_pool/queue/lock_free_linked_queue.hpp"
+#include "thread_pool/queue/ring_blocking_queue.hpp"
+#include "thread_pool/queue/segmented_ring_blocking_queue.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+
+using namespace thread_pool;
+
+namespace
+{
+	using value_type = std::uint64_t;
+
+	constexpr std::size_t queue_capacity = 64;
+	constexpr std::size_t producer_count = 4;
+	constexpr std::size_t consumer_count = 4;
+	constexpr value_type items_per_producer = 20000;
+
+	std::uint32_t stress_seed()
+	{
+		// _CRT_SECURE_NO_WARNINGS is defined for MSVC, which otherwise rejects std::getenv (C4996)
+		if(const char* seed = std::getenv("THREAD_POOL_STRESS_SEED"))
+		{
+			return static_cast<std::uint32_t>(std::strtoul(seed, nullptr, 10));
+		}
+		return 42;
+	}
+
+	template<typename Q>
+	std::unique_ptr<Q> make_queue(std::size_t capacity)
+	{
+		if constexpr(std::constructible_from<Q, std::size_t>)
+		{
+			return std::make_unique<Q>(capacity);
+		}
+		else
+		{
+			return std::make_unique<Q>();
+		}
+	}
+
+	void report(const char* scenario, std::size_t ops, std::chrono::steady_clock::duration elapsed)
+	{
+		const auto* test_info = testing::UnitTest::GetInstance()->current_test_info();
+		const double seconds = std::chrono::duration<double>(elapsed).count();
+
+		std::cout << "[  STRESS  ] " << test_info->type_param() << " " << scenario << ": "
+		          << static_cast<std::size_t>(static_cast<double>(ops) / seconds) << " ops/s\n";
+	}
+
+	// Pushes value using the operation selected by the random generator, returns false once the queue is closed.
+	template<typename Q>
+	bool stress_push(Q& queue, value_type value, std::mt19937& random)
+	{
+		while(true)
+		{
+			QueueOpStatus status;
+			switch(random() % 3)
+			{
+				case 0:
+					status = queue.wait_push(value);
+					break;
+				case 1:
+					status = queue.try_push(value);
+					break;
+				default:
+					status = queue.wait_push_for(value, std::chrono::microseconds(random() % 100));
+					break;
+			}
+
+			if(status == QueueOpStatus::success)
+			{
+				return true;
+			}
+			if(status == QueueOpStatus::closed)
+			{
+				return false;
+			}
+			std::this_thread::yield();
+		}
+	}
+
+	// Pops value using the operation selected by the random generator, returns false once the queue is closed and empty.
+	template<typename Q>
+	bool stress_pop(Q& queue, value_type& value, std::mt19937& random)
+	{
+		while(true)
+		{
+			QueueOpStatus status;
+			switch(random() % 3)
+			{
+				case 0:
+					status = queue.wait_pop(value);
+					break;
+				case 1:
+					status = queue.try_pop(value);
+					break;
+				default:
+					status = queue.wait_pop_for(value, std::chrono::microseconds(random() % 100));
+					break;
+			}
+
+			if(status == QueueOpStatus::success)
+			{
+				return true;
+			}
+			if(status == QueueOpStatus::closed)
+			{
+				return false;
+			}
+			std::this_thread::yield();
+		}
+	}
+
+	struct ConsumerResult
+	{
+		std::vector<value_type> values;
+		value_type checksum = 0;
+	};
+}
+
+template <typename Q>
+requires detail::task_queue<Q>
+class queue_stress_test : public testing::Test
+{
+protected:
+	queue_stress_test()
+	:
+		queue(make_queue<Q>(queue_capacity))
+	{}
+
+	std::unique_ptr<Q> queue;
+
+	std::vector<ConsumerResult> run_consumers(std::size_t count, std::uint32_t seed)
+	{
+		std::vector<ConsumerResult> results(count);
+		std::vector<std::thread> consumers;
+		for(std::size_t i = 0; i < count; ++i)
+		{
+			consumers.emplace_back(
+					[this, &result = results[i], seed = seed + static_cast<std::uint32_t>(i)]()
+					{
+						std::mt19937 random(seed);
+						value_type value;
+						while(stress_pop(*queue, value, random))
+						{
+							result.values.push_back(value);
+							result.checksum += value;
+						}
+					}
+			);
+		}
+		for(auto& consumer: consumers)
+		{
+			consumer.join();
+		}
+		return results;
+	}
+};
+
+TYPED_TEST_SUITE_P(queue_stress_test);
+
+TYPED_TEST_P(queue_stress_test, no_loss_no_duplication)
+{
+	const std::uint32_t seed = stress_seed();
+	const auto start = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> producers;
+	for(std::size_t p = 0; p < producer_count; ++p)
+	{
+		producers.emplace_back(
+				[this, p, seed]()
+				{
+					std::mt19937 random(seed ^ static_cast<std::uint32_t>(p + 1) * 7919u);
+					for(value_type i = 0; i < items_per_producer; ++i)
+					{
+						const bool pushed = stress_push(*this->queue, p * items_per_producer + i, random);
+						EXPECT_TRUE(pushed) << "queue closed before producer " << p << " finished";
+						if(!pushed)
+						{
+							return;
+						}
+					}
+				}
+		);
+	}
+
+	std::thread closer(
+			[this, &producers]()
+			{
+				for(auto& producer: producers)
+				{
+					producer.join();
+				}
+				this->queue->close();
+			}
+	);
+
+	auto results = this->run_consumers(consumer_count, seed);
+	closer.join();
+
+	const auto elapsed = std::chrono::steady_clock::now() - start;
+
+	const value_type total = producer_count * items_per_producer;
+	std::vector<unsigned char> seen(total, 0);
+	value_type checksum = 0;
+	for(const auto& result: results)
+	{
+		checksum += result.checksum;
+		for(auto value: result.values)
+		{
+			ASSERT_LT(value, total);
+			ASSERT_EQ(0, seen[value]) << "duplicated value " << value;
+			seen[value] = 1;
+		}
+	}
+
+	EXPECT_EQ(total * (total - 1) / 2, checksum);
+	for(value_type value = 0; value < total; ++value)
+	{
+		ASSERT_EQ(1, seen[value]) << "lost value " << value;
+	}
+
+	report("no_loss_no_duplication", 2 * total, elapsed);
+}
+
+TYPED_TEST_P(queue_stress_test, random_close)
+{
+	const std::uint32_t seed = stress_seed();
+	std::mt19937 random(seed);
+
+	for(int round = 0; round < 8; ++round)
+	{
+		this->queue = make_queue<TypeParam>(queue_capacity);
+
+		std::vector<value_type> pushed_checksums(producer_count, 0);
+		std::vector<value_type> pushed_counts(producer_count, 0);
+
+		std::vector<std::thread> producers;
+		for(std::size_t p = 0; p < producer_count; ++p)
+		{
+			producers.emplace_back(
+					[this, p, &pushed_checksums, &pushed_counts, seed = random()]()
+					{
+						std::mt19937 producer_random(seed);
+						for(value_type i = 0; i < items_per_producer; ++i)
+						{
+							const value_type value = p * items_per_producer + i;
+							if(!stress_push(*this->queue, value, producer_random))
+							{
+								return;
+							}
+							pushed_checksums[p] += value;
+							++pushed_counts[p];
+						}
+					}
+			);
+		}
+
+		std::thread closer(
+				[this, delay = std::chrono::microseconds(random() % 5000)]()
+				{
+					std::this_thread::sleep_for(delay);
+					this->queue->close();
+				}
+		);
+
+		auto results = this->run_consumers(consumer_count, random());
+		closer.join();
+		for(auto& producer: producers)
+		{
+			producer.join();
+		}
+
+		value_type pushed_checksum = 0;
+		value_type pushed_count = 0;
+		for(std::size_t p = 0; p < producer_count; ++p)
+		{
+			pushed_checksum += pushed_checksums[p];
+			pushed_count += pushed_counts[p];
+		}
+
+		value_type popped_checksum = 0;
+		value_type popped_count = 0;
+		for(const auto& result: results)
+		{
+			popped_checksum += result.checksum;
+			popped_count += result.values.size();
+		}
+
+		ASSERT_TRUE(this->queue->closed());
+		ASSERT_EQ(pushed_count, popped_count) << "round " << round;
+		ASSERT_EQ(pushed_checksum, popped_checksum) << "round " << round;
+	}
+}
+
+TYPED_TEST_P(queue_stress_test, ping_pong_wakeups)
+{
+	constexpr value_type rounds = 20000;
+
+	auto request = make_queue<TypeParam>(1);
+	auto response = make_queue<TypeParam>(1);
+
+	const auto start = std::chrono::steady_clock::now();
+
+	std::thread echo(
+			[&]()
+			{
+				value_type value;
+				while(request->wait_pop(value) == QueueOpStatus::success)
+				{
+					response->push(value + 1);
+				}
+			}
+	);
+
+	for(value_type i = 0; i < rounds; ++i)
+	{
+		request->push(i);
+		const value_type echoed = response->value_pop();
+		EXPECT_EQ(i + 1, echoed);
+		if(echoed != i + 1)
+		{
+			break;
+		}
+	}
+	// echo is joined on failure too, a joinable thread would terminate the test binary
+	request->close();
+	echo.join();
+
+	report("ping_pong_wakeups", 2 * rounds, std::chrono::steady_clock::now() - start);
+}
+
+REGISTER_TYPED_TEST_SUITE_P(
+	queue_stress_test,
+	no_loss_no_duplication,
+	random_close,
+	ping_pong_wakeups
+);
+
+using StressedQueues = testing::Types<
+		NaiveBlockingQueue<value_type>,
+		EventCountNaiveBlockingQueue<value_type>,
+		RingBlockingQueue<value_type>,
+		EventCountRingBlockingQueue<value_type>,
+		SegmentedRingBlockingQueue<value_type>,
+		LockFreeLinkedQueue<value_type>
+>;
+
+INSTANTIATE_TYPED_TEST_SUITE_P(Stress, queue_stress_test, StressedQueues, );
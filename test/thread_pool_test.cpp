@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 #include <thread_pool/thread_pool.hpp>
+#include <thread_pool/queue/ring_blocking_queue.hpp>
+#include <thread_pool/queue/lock_free_linked_queue.hpp>
 
 
 TEST(ThreadPoolTest, thread_count)
@@ -85,9 +87,579 @@ TEST(ThreadPoolTest, throw_handling)
 	ASSERT_THROW(task_2.get(), exception_2);
 }
 
+TEST(ThreadPoolTest, sharded_thread_count)
+{
+	thread_pool::ThreadPool thread_pool_1(4, 2);
+	thread_pool::ThreadPool thread_pool_2(2, 8);
+
+	ASSERT_EQ(4, thread_pool_1.thread_count());
+	ASSERT_EQ(2, thread_pool_1.shard_count());
+	ASSERT_EQ(2, thread_pool_2.shard_count());
+}
+
+TEST(ThreadPoolTest, sharded_ring_queue)
+{
+	thread_pool::ThreadPool<thread_pool::RingBlockingQueue> thread_pool(4, 3, 16);
+
+	std::vector<std::future<int>> results;
+	for(int i = 0; i < 100; ++i)
+	{
+		results.push_back(thread_pool.enqueue([](int x){ return x * 2; }, i));
+	}
+
+	for(int i = 0; i < 100; ++i)
+	{
+		ASSERT_EQ(i * 2, results[i].get());
+	}
+}
+
+TEST(ThreadPoolTest, try_post_does_not_block)
+{
+	thread_pool::ThreadPool<thread_pool::RingBlockingQueue> thread_pool(1, 1, 2);
+
+	std::promise<void> started;
+	std::promise<void> gate;
+	auto blocker = thread_pool.enqueue([&started, gate_future = gate.get_future()](){ started.set_value(); gate_future.wait(); });
+	started.get_future().wait();
+
+	std::atomic<int> ran = 0;
+	int accepted = 0;
+	while(accepted < 64 && thread_pool.try_post([&ran](){ ++ran; }))
+	{
+		++accepted;
+	}
+	ASSERT_LT(accepted, 64);
+
+	gate.set_value();
+	blocker.get();
+	// a single worker runs them in order, the accepted tasks are done once this one is
+	thread_pool.enqueue([](){}).get();
+	ASSERT_EQ(accepted, ran.load());
+}
+
+TEST(ThreadPoolTest, lock_free_linked_queue)
+{
+	thread_pool::ThreadPool<thread_pool::LockFreeLinkedQueue> thread_pool(4, 2);
+
+	std::vector<std::future<int>> results;
+	for(int i = 0; i < 500; ++i)
+	{
+		results.push_back(thread_pool.enqueue([](int x){ return x + 1; }, i));
+	}
+
+	for(int i = 0; i < 500; ++i)
+	{
+		ASSERT_EQ(i + 1, results[i].get());
+	}
+}
+
+TEST(ThreadPoolTest, sharded_drain_on_destruction)
+{
+	std::atomic<int> counter = 0;
+	{
+		thread_pool::ThreadPool thread_pool(3, 3);
+		for(int i = 0; i < 50; ++i)
+		{
+			static_cast<void>(thread_pool.enqueue([&counter](){ ++counter; }));
+		}
+	}
+	ASSERT_EQ(50, counter.load());
+}
+
+TEST(ThreadPoolTest, enqueue_until_drops_expired)
+{
+	thread_pool::ThreadPool thread_pool(1);
+
+	std::promise<void> release;
+	auto blocker = thread_pool.enqueue([&release](){ release.get_future().wait(); });
+
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(5);
+	auto stale = thread_pool.enqueue_until(deadline, [](){ return 1; });
+	auto fresh = thread_pool.enqueue_until(deadline + std::chrono::hours(1), [](){ return 2; });
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	release.set_value();
+
+	blocker.get();
+	ASSERT_THROW(stale.get(), std::future_error);
+	ASSERT_EQ(2, fresh.get());
+}
+
+namespace
+{
+	struct CountingMetrics
+	{
+		static constexpr bool enabled = true;
+		struct task_token {};
+
+		std::atomic<std::size_t> enqueued = 0;
+		std::atomic<std::size_t> started = 0;
+		std::atomic<std::size_t> finished = 0;
+
+		task_token on_enqueue(thread_pool::TaskLabel) noexcept { ++enqueued; return {}; }
+		void on_task_start(task_token&, std::size_t) noexcept { ++started; }
+		void on_task_end(task_token&, std::size_t) noexcept { ++finished; }
+	};
+
+	struct CountingThreadFactory: thread_pool::StdThreadFactory
+	{
+		std::shared_ptr<std::atomic<std::size_t>> created = std::make_shared<std::atomic<std::size_t>>(0);
+
+		template<typename F>
+		thread_type create(std::size_t index, F&& fun)
+		{
+			++*created;
+			return StdThreadFactory::create(index, std::forward<F>(fun));
+		}
+	};
+
+	struct CustomPolicy: thread_pool::DefaultPolicy
+	{
+		using wait_strategy = thread_pool::SpinWait<16>;
+		using result_policy = thread_pool::DetachedResult;
+		using metrics = CountingMetrics;
+		using thread_factory = CountingThreadFactory;
+	};
+}
+
+TEST(ThreadPoolTest, custom_policy)
+{
+	CountingThreadFactory factory;
+	std::atomic<int> counter = 0;
+	{
+		thread_pool::ThreadPool<thread_pool::NaiveBlockingQueue, CustomPolicy> thread_pool(factory, 3, 1);
+		static_assert(std::is_void_v<decltype(thread_pool.enqueue([](){}))>);
+
+		for(int i = 0; i < 20; ++i)
+		{
+			thread_pool.enqueue([&counter](int x){ counter += x; }, 2);
+		}
+		EXPECT_EQ(20, thread_pool.metrics().enqueued.load());
+		EXPECT_EQ(3, factory.created->load());
+	}
+	ASSERT_EQ(40, counter.load());
+}
+
+namespace
+{
+	std::atomic<int> live_worker_states = 0;
+
+	struct WorkerBuffer
+	{
+		explicit WorkerBuffer(std::size_t worker_index)
+		:
+			index(worker_index),
+			thread_id(std::this_thread::get_id())
+		{
+			++live_worker_states;
+		}
+
+		~WorkerBuffer()
+		{
+			--live_worker_states;
+		}
+
+		std::size_t index;
+		std::thread::id thread_id;
+		int runs = 0;
+	};
+
+	struct RequestId
+	{
+		int value = 0;
+	};
+
+	struct StatefulPolicy: thread_pool::DefaultPolicy
+	{
+		using worker_state = WorkerBuffer;
+		using context = thread_pool::ThreadLocalContext<RequestId>;
+	};
+
+	using StatefulPool = thread_pool::ThreadPool<thread_pool::NaiveBlockingQueue, StatefulPolicy>;
+}
+
+TEST(ThreadPoolTest, worker_state)
+{
+	{
+		StatefulPool thread_pool(3);
+		ASSERT_EQ(3, live_worker_states.load());
+		ASSERT_EQ(nullptr, StatefulPool::current_worker());
+		ASSERT_EQ(nullptr, thread_pool::ThreadPool<>::current_worker());
+
+		auto task = thread_pool.enqueue(
+				[]()
+				{
+					WorkerBuffer* state = StatefulPool::current_worker();
+					EXPECT_NE(nullptr, state);
+					EXPECT_EQ(std::this_thread::get_id(), state->thread_id);
+					EXPECT_EQ(nullptr, thread_pool::ThreadPool<>::current_worker());
+					return state->index;
+				}
+		);
+		ASSERT_LT(task.get(), 3);
+	}
+	ASSERT_EQ(0, live_worker_states.load());
+}
+
+TEST(ThreadPoolTest, context_propagation)
+{
+	using Context = thread_pool::ThreadLocalContext<RequestId>;
+	StatefulPool thread_pool(2);
+
+	Context::current().value = 17;
+	auto task_1 = thread_pool.enqueue([](){ return Context::current().value; });
+
+	Context::current().value = 23;
+	auto task_2 = thread_pool.enqueue([](){ return Context::current().value; });
+	Context::current().value = 0;
+
+	ASSERT_EQ(17, task_1.get());
+	ASSERT_EQ(23, task_2.get());
+
+	auto task_3 = thread_pool.enqueue([](){ return Context::current().value; });
+	ASSERT_EQ(0, task_3.get());
+}
+
+namespace
+{
+	struct CopyCounter
+	{
+		static inline std::atomic<int> copies = 0;
+		static inline std::atomic<int> moves = 0;
+
+		CopyCounter() = default;
+		CopyCounter(const CopyCounter&) { ++copies; }
+		CopyCounter(CopyCounter&&) noexcept { ++moves; }
+		CopyCounter& operator=(const CopyCounter&) { ++copies; return *this; }
+		CopyCounter& operator=(CopyCounter&&) noexcept { ++moves; return *this; }
+
+		static void reset()
+		{
+			copies = 0;
+			moves = 0;
+		}
+	};
+
+	struct Accumulator
+	{
+		int base;
+
+		int add(int x) const
+		{
+			return base + x;
+		}
+	};
+}
+
+TEST(ThreadPoolTest, argument_copies_and_moves)
+{
+	thread_pool::ThreadPool thread_pool(1);
+
+	CopyCounter::reset();
+	thread_pool.enqueue([](CopyCounter){}, CopyCounter()).get();
+	EXPECT_EQ(0, CopyCounter::copies.load());
+	// into task storage and into the parameter
+	EXPECT_EQ(2, CopyCounter::moves.load());
+
+	CopyCounter::reset();
+	CopyCounter lvalue;
+	thread_pool.enqueue([](const CopyCounter&){}, lvalue).get();
+	EXPECT_EQ(1, CopyCounter::copies.load());
+	EXPECT_EQ(0, CopyCounter::moves.load());
+
+	CopyCounter::reset();
+	thread_pool.enqueue([counter = CopyCounter()](){ static_cast<void>(counter); }).get();
+	EXPECT_EQ(0, CopyCounter::copies.load());
+	EXPECT_EQ(1, CopyCounter::moves.load());
+}
+
+TEST(ThreadPoolTest, move_only_callable_and_arguments)
+{
+	thread_pool::ThreadPool thread_pool(2);
+
+	auto value = std::make_unique<int>(4);
+	auto task_1 = thread_pool.enqueue(
+			[owned = std::make_unique<int>(3)](std::unique_ptr<int> arg){ return *owned + *arg; },
+			std::move(value)
+	);
+	ASSERT_EQ(7, task_1.get());
+}
+
+TEST(ThreadPoolTest, member_function_pointer)
+{
+	thread_pool::ThreadPool thread_pool(2);
+
+	Accumulator accumulator{10};
+	auto task_1 = thread_pool.enqueue(&Accumulator::add, &accumulator, 5);
+	auto task_2 = thread_pool.enqueue(&Accumulator::base, accumulator);
+	auto task_3 = thread_pool.enqueue([](int& x){ return ++x; }, std::ref(accumulator.base));
+
+	ASSERT_EQ(15, task_1.get());
+	ASSERT_EQ(10, task_2.get());
+	ASSERT_EQ(11, task_3.get());
+	ASSERT_EQ(11, accumulator.base);
+}
+
+TEST(ThreadPoolTest, blocking_tasks_are_compensated)
+{
+	thread_pool::ThreadPool thread_pool(2);
+
+	std::promise<void> gate;
+	std::shared_future<void> gate_future = gate.get_future().share();
+
+	auto blocked_1 = thread_pool.enqueue_blocking([gate_future](){ gate_future.wait(); return 1; });
+	auto blocked_2 = thread_pool.enqueue_blocking([gate_future](){ gate_future.wait(); return 2; });
+
+	auto task = thread_pool.enqueue([](){ return 3; });
+	ASSERT_EQ(std::future_status::ready, task.wait_for(std::chrono::seconds(5)));
+	ASSERT_EQ(3, task.get());
+
+	gate.set_value();
+	ASSERT_EQ(1, blocked_1.get());
+	ASSERT_EQ(2, blocked_2.get());
+
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while(thread_pool.compensating_thread_count() != 0 && std::chrono::steady_clock::now() < deadline)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	}
+	ASSERT_EQ(0, thread_pool.compensating_thread_count());
+}
+
+TEST(ThreadPoolTest, blocking_section_outside_worker)
+{
+	thread_pool::ThreadPool thread_pool(1);
+	thread_pool.set_max_compensating_threads(0);
+
+	{
+		auto section = thread_pool.blocking_section();
+		ASSERT_EQ(0, thread_pool.compensating_thread_count());
+	}
+
+	auto task = thread_pool.enqueue([&thread_pool](){
+		auto section = thread_pool.blocking_section();
+		return thread_pool.compensating_thread_count();
+	});
+	ASSERT_EQ(0, task.get());
+}
+
+TEST(ThreadPoolTest, map_reduce_sum)
+{
+	thread_pool::ThreadPool<thread_pool::RingBlockingQueue> thread_pool(4, 2, 8);
+
+	auto sum = thread_pool.map_reduce(
+			100000,
+			std::uint64_t{7},
+			[](std::size_t i){ return static_cast<std::uint64_t>(i); },
+			std::plus<>()
+	);
+	ASSERT_EQ(7 + 99999ULL * 100000 / 2, sum.get());
+
+	auto empty = thread_pool.map_reduce(0, 3, [](std::size_t){ return 1; }, std::plus<>());
+	ASSERT_EQ(3, empty.get());
+}
+
+TEST(ThreadPoolTest, map_reduce_custom_combine_and_errors)
+{
+	thread_pool::ThreadPool thread_pool(3);
+
+	auto maximum = thread_pool.map_reduce(
+			1000,
+			0,
+			[](std::size_t i){ return static_cast<int>((i * 7919) % 1000); },
+			[](int a, int b){ return std::max(a, b); },
+			16
+	);
+	ASSERT_EQ(999, maximum.get());
+
+	auto failing = thread_pool.map_reduce(
+			100,
+			0,
+			[](std::size_t i) -> int
+			{
+				if(i == 42)
+				{
+					throw std::runtime_error("map failed");
+				}
+				return 1;
+			},
+			std::plus<>()
+	);
+	ASSERT_THROW(failing.get(), std::runtime_error);
+}
+
 template<template <typename> class T>
 class ThreadPoolTest : public testing::Test
 {
 protected:
 	thread_pool::ThreadPool<T> thread_pool_;
-};
\ No newline at end of file
+};
+TEST(ThreadPoolTest, stats)
+{
+	thread_pool::ThreadPool thread_pool(2, 2);
+
+	thread_pool::PoolStats stats = thread_pool.stats();
+	ASSERT_EQ(2, stats.thread_count);
+	ASSERT_EQ(2, stats.shards.size());
+	ASSERT_EQ(0, stats.queued);
+
+	std::promise<void> gate;
+	std::shared_future<void> gate_future = gate.get_future().share();
+	std::atomic<int> started = 0;
+
+	std::vector<std::future<void>> tasks;
+	for(int i = 0; i < 5; ++i)
+	{
+		tasks.push_back(thread_pool.enqueue([&started, gate_future](){ ++started; gate_future.wait(); }));
+	}
+
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while(started.load() != 2 && std::chrono::steady_clock::now() < deadline)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	}
+
+	stats = thread_pool.stats();
+	ASSERT_EQ(2, stats.active_workers);
+	ASSERT_EQ(0, stats.idle_workers);
+	ASSERT_EQ(0, stats.compensating_workers);
+	ASSERT_EQ(3, stats.queued);
+	ASSERT_GE(stats.queue_high_water_mark, 2);
+
+	gate.set_value();
+	for(auto& task: tasks)
+	{
+		task.get();
+	}
+}
+
+TEST(ThreadPoolTest, idle_workers_steal_from_busy_shard)
+{
+	thread_pool::ThreadPool thread_pool(4, 4);
+
+	std::promise<void> started;
+	std::promise<void> gate;
+	auto blocker = thread_pool.enqueue([&started, gate_future = gate.get_future()](){ started.set_value(); gate_future.wait(); });
+	started.get_future().wait();
+
+	// one at a time, so a task on the home shard of the blocked worker is the only queued one
+	for(int i = 0; i < 8; ++i)
+	{
+		auto task = thread_pool.enqueue([i](){ return i; });
+		ASSERT_EQ(std::future_status::ready, task.wait_for(std::chrono::seconds(5)));
+		ASSERT_EQ(i, task.get());
+	}
+
+	gate.set_value();
+	blocker.get();
+}
+
+TEST(ThreadPoolTest, enqueue_keyed)
+{
+	thread_pool::ThreadPool thread_pool(4, 4);
+
+	std::vector<std::future<std::size_t>> results;
+	for(std::size_t key = 0; key < 64; ++key)
+	{
+		ASSERT_LT(thread_pool.shard_for(key), 4);
+		ASSERT_EQ(thread_pool.shard_for(key), thread_pool.shard_for(key));
+		results.push_back(thread_pool.enqueue_keyed(key, [](std::size_t value){ return value * 2; }, key));
+	}
+	for(std::size_t key = 0; key < 64; ++key)
+	{
+		ASSERT_EQ(key * 2, results[key].get());
+	}
+
+	auto named = thread_pool.enqueue_keyed(std::string("user-7"), [](){ return 7; });
+	ASSERT_EQ(7, named.get());
+}
+
+TEST(ThreadPoolTest, enqueue_keyed_to_busy_shard)
+{
+	thread_pool::ThreadPool thread_pool(4, 4);
+
+	std::promise<void> started;
+	std::promise<void> gate;
+	auto blocker = thread_pool.enqueue_keyed(0, [&started, gate_future = gate.get_future()](){ started.set_value(); gate_future.wait(); });
+	started.get_future().wait();
+
+	// one of the shards is the home shard of the blocked worker
+	for(std::size_t shard = 0; shard < thread_pool.shard_count(); ++shard)
+	{
+		std::size_t key = 0;
+		while(thread_pool.shard_for(key) != shard)
+		{
+			++key;
+		}
+
+		auto task = thread_pool.enqueue_keyed(key, [key](){ return key; });
+		ASSERT_EQ(std::future_status::ready, task.wait_for(std::chrono::seconds(5)));
+		ASSERT_EQ(key, task.get());
+	}
+
+	gate.set_value();
+	blocker.get();
+}
+
+TEST(ThreadPoolTest, jump_hash_is_consistent)
+{
+	std::size_t moved = 0;
+	for(std::uint64_t key = 0; key < 10000; ++key)
+	{
+		const std::size_t before = thread_pool::detail::jump_hash(key * 0x9E3779B97F4A7C15ULL, 8);
+		const std::size_t after = thread_pool::detail::jump_hash(key * 0x9E3779B97F4A7C15ULL, 9);
+		if(before != after)
+		{
+			ASSERT_EQ(8, after);
+			++moved;
+		}
+	}
+	// about 1/9 of the keys move to the new bucket
+	ASSERT_GT(moved, 700);
+	ASSERT_LT(moved, 1600);
+}
+
+TEST(ThreadPoolTest, lazy_start)
+{
+	thread_pool::ThreadPool<thread_pool::RingBlockingQueue> thread_pool(thread_pool::lazy_start, 4, 2, 64);
+	thread_pool.reserve(128);
+	ASSERT_EQ(4, thread_pool.thread_count());
+	ASSERT_EQ(0, thread_pool.started_thread_count());
+	ASSERT_EQ(0, thread_pool.stats().started_workers);
+
+	ASSERT_EQ(1, thread_pool.enqueue([](){ return 1; }).get());
+	ASSERT_GE(thread_pool.started_thread_count(), 1);
+
+	// tasks waiting for each other need all workers, the backlog keeps spawning them
+	thread_pool::detail::Latch all_running(4);
+	std::vector<std::future<void>> tasks;
+	for(int i = 0; i < 4; ++i)
+	{
+		tasks.push_back(thread_pool.enqueue([&all_running](){ all_running.arrive_and_wait(); }));
+	}
+	for(auto& task: tasks)
+	{
+		ASSERT_EQ(std::future_status::ready, task.wait_for(std::chrono::seconds(5)));
+	}
+	ASSERT_EQ(4, thread_pool.started_thread_count());
+}
+
+TEST(ThreadPoolTest, lazy_start_sharded)
+{
+	thread_pool::ThreadPool thread_pool(thread_pool::lazy_start, 4, 4);
+
+	// one task at a time, each lands on a shard whose worker is not started yet
+	for(int i = 0; i < 8; ++i)
+	{
+		auto task = thread_pool.enqueue([i](){ return i; });
+		ASSERT_EQ(std::future_status::ready, task.wait_for(std::chrono::seconds(5)));
+		ASSERT_EQ(i, task.get());
+	}
+	ASSERT_EQ(4, thread_pool.started_thread_count());
+}
+
+TEST(ThreadPoolTest, lazy_start_destroyed_unused)
+{
+	thread_pool::ThreadPool thread_pool(thread_pool::lazy_start);
+	ASSERT_EQ(0, thread_pool.started_thread_count());
+}
@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+#include <thread_pool/thread_pool.hpp>
+#include <thread_pool/trace/watchdog.hpp>
+#include <thread_pool/queue/ring_blocking_queue.hpp>
+
+#include <future>
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+using namespace thread_pool;
+
+namespace
+{
+	struct WatchedPolicy: DefaultPolicy
+	{
+		using metrics = Watchdog;
+	};
+}
+
+TEST(WatchdogTest, reports_long_running_task_once)
+{
+	ThreadPool<NaiveBlockingQueue, WatchedPolicy> thread_pool(1);
+
+	std::mutex reports_mutex;
+	std::vector<StallReport> reports;
+	thread_pool.metrics().start(
+			WatchdogOptions{
+				.task_threshold = std::chrono::milliseconds(20),
+				.queue_threshold = std::chrono::nanoseconds(0),
+				.interval = std::chrono::milliseconds(5)
+			},
+			[&](const StallReport& report)
+			{
+				std::scoped_lock lock(reports_mutex);
+				reports.push_back(report);
+			}
+	);
+
+	std::promise<void> gate;
+	auto task = thread_pool.enqueue(TaskLabel("stuck"), [gate_future = gate.get_future()](){ gate_future.wait(); });
+
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while(std::chrono::steady_clock::now() < deadline)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		std::scoped_lock lock(reports_mutex);
+		if(!reports.empty())
+		{
+			break;
+		}
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(30));
+
+	gate.set_value();
+	task.get();
+	thread_pool.metrics().stop();
+
+	ASSERT_EQ(1, reports.size());
+	EXPECT_EQ(StallReport::Kind::task, reports[0].kind);
+	EXPECT_EQ(0, reports[0].worker);
+	EXPECT_EQ(std::string("stuck"), reports[0].label);
+	EXPECT_GE(reports[0].elapsed, std::chrono::milliseconds(20));
+}
+
+TEST(WatchdogTest, reports_queue_stall)
+{
+	Watchdog watchdog(4, 2);
+	const WatchdogOptions options{
+		.task_threshold = std::chrono::nanoseconds(0),
+		.queue_threshold = std::chrono::milliseconds(10),
+		.interval = std::chrono::milliseconds(1)
+	};
+
+	std::vector<StallReport> reports;
+	auto callback = [&](const StallReport& report){ reports.push_back(report); };
+
+	auto token_1 = watchdog.on_enqueue(TaskLabel("first"));
+	watchdog.on_enqueue(TaskLabel("second"));
+	EXPECT_EQ(2, watchdog.queue_depth());
+
+	watchdog.check(options, callback);
+	EXPECT_TRUE(reports.empty());
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(15));
+	watchdog.check(options, callback);
+	watchdog.check(options, callback);
+	ASSERT_EQ(1, reports.size());
+	EXPECT_EQ(StallReport::Kind::queue, reports[0].kind);
+	EXPECT_EQ(StallReport::no_worker, reports[0].worker);
+	EXPECT_EQ(2, reports[0].queue_depth);
+
+	// oldest task started, the next one is reported on its own
+	watchdog.on_task_start(token_1, 0);
+	watchdog.on_task_end(token_1, 0);
+	watchdog.check(options, callback);
+	ASSERT_EQ(2, reports.size());
+	EXPECT_EQ(1, reports[1].queue_depth);
+}
+
+TEST(WatchdogTest, refused_tasks_leave_the_queue_depth)
+{
+	ThreadPool<RingBlockingQueue, WatchedPolicy> thread_pool(1, 1, 2);
+
+	std::promise<void> started;
+	std::promise<void> gate;
+	auto blocker = thread_pool.enqueue([&started, gate_future = gate.get_future()](){ started.set_value(); gate_future.wait(); });
+	started.get_future().wait();
+
+	int accepted = 0;
+	while(accepted < 64 && thread_pool.try_post([](){}))
+	{
+		++accepted;
+	}
+	ASSERT_LT(accepted, 64);
+	EXPECT_EQ(static_cast<std::size_t>(accepted), thread_pool.metrics().queue_depth());
+
+	gate.set_value();
+	blocker.get();
+	thread_pool.enqueue([](){}).get();
+	EXPECT_EQ(0, thread_pool.metrics().queue_depth());
+}
@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+#include <thread_pool/thread_pool.hpp>
+#include <thread_pool/trace/workload_recorder.hpp>
+#include <thread_pool/trace/workload_replay.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+
+using namespace thread_pool;
+
+namespace
+{
+	struct RecordingPolicy: DefaultPolicy
+	{
+		using metrics = WorkloadRecorder;
+	};
+}
+
+TEST(WorkloadTest, records_submissions)
+{
+	ThreadPool<NaiveBlockingQueue, RecordingPolicy> thread_pool(2);
+
+	auto submit = [&thread_pool](const char* label)
+	{
+		for(int i = 0; i < 5; ++i)
+		{
+			thread_pool.enqueue(TaskLabel(label), [](){ std::this_thread::sleep_for(std::chrono::milliseconds(1)); }).get();
+		}
+	};
+	std::thread submitter_1(submit, "first");
+	std::thread submitter_2(submit, "second");
+	submitter_1.join();
+	submitter_2.join();
+
+	// on_task_end runs right after the future is satisfied
+	WorkloadTrace trace;
+	for(int attempt = 0; attempt < 100; ++attempt)
+	{
+		trace = thread_pool.metrics().trace();
+		if(trace.events.size() == 10)
+		{
+			break;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	ASSERT_EQ(10, trace.events.size());
+	ASSERT_EQ(0, thread_pool.metrics().dropped());
+	ASSERT_EQ(std::chrono::nanoseconds(0), trace.events.front().submit_time);
+
+	for(std::size_t i = 0; i < trace.events.size(); ++i)
+	{
+		const auto& event = trace.events[i];
+		ASSERT_LT(event.submitter, 2);
+		ASSERT_GE(event.duration, std::chrono::milliseconds(1));
+		if(i > 0)
+		{
+			ASSERT_LE(trace.events[i - 1].submit_time, event.submit_time);
+		}
+
+		// submitter indices follow the threads, each of them submits a single label
+		const auto& first_of_submitter = *std::find_if(trace.events.begin(), trace.events.end(), [&](const auto& other){
+			return other.submitter == event.submitter;
+		});
+		ASSERT_EQ(first_of_submitter.label, event.label);
+	}
+
+	thread_pool.metrics().clear();
+	ASSERT_TRUE(thread_pool.metrics().trace().events.empty());
+}
+
+TEST(WorkloadTest, trace_round_trip)
+{
+	WorkloadTrace trace;
+	trace.events.push_back(WorkloadEvent{std::chrono::nanoseconds(0), 0, std::chrono::nanoseconds(1500), "parse"});
+	trace.events.push_back(WorkloadEvent{std::chrono::nanoseconds(20), 1, std::chrono::nanoseconds(7), ""});
+
+	std::stringstream stream;
+	trace.write(stream);
+	const WorkloadTrace read = WorkloadTrace::read(stream);
+
+	ASSERT_EQ(2, read.events.size());
+	ASSERT_EQ(std::chrono::nanoseconds(1500), read.events[0].duration);
+	ASSERT_EQ("parse", read.events[0].label);
+	ASSERT_EQ(1, read.events[1].submitter);
+	ASSERT_EQ("", read.events[1].label);
+
+	std::stringstream malformed("submit_ns,submitter,duration_ns,label\n1;2;3\n");
+	ASSERT_THROW(static_cast<void>(WorkloadTrace::read(malformed)), std::runtime_error);
+}
+
+TEST(WorkloadTest, replay)
+{
+	WorkloadTrace trace;
+	for(int i = 0; i < 50; ++i)
+	{
+		trace.events.push_back(WorkloadEvent{
+				std::chrono::microseconds(100 * i),
+				static_cast<std::size_t>(i % 2),
+				std::chrono::microseconds(20),
+				"task"
+		});
+	}
+
+	ThreadPool thread_pool(2);
+	const ReplayResult result = replay_workload(thread_pool, trace);
+
+	ASSERT_EQ(50, result.tasks);
+	// the last task is not submitted before its scheduled 4900us and runs for 20us
+	ASSERT_GE(result.makespan, std::chrono::microseconds(4920));
+	ASSERT_GT(result.tasks_per_second, 0.0);
+	ASSERT_LE(result.queue_wait.p50, result.queue_wait.p90);
+	ASSERT_LE(result.queue_wait.p99, result.queue_wait.max);
+	ASSERT_GE(result.end_to_end.p50, std::chrono::microseconds(20));
+	ASSERT_LE(result.end_to_end.p90, result.end_to_end.max);
+}